@@ -0,0 +1,257 @@
+/*
+ * Binární vyhledávací strom — AVL varianta
+ *
+ * Strom s rozhraním ze souboru btree.h, který se vyvažuje průběžně při
+ * vkládání a mazání pomocí rotací. Výšky podstromů libovolného uzlu se liší
+ * nejvýše o jedna, vyhledávání je tak v nejhorším případě logaritmické
+ * a strom není potřeba vyvažovat pomocí bst_balance.
+ */
+
+#include "../btree.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/// @brief Gets height of the subtree
+/// @param tree subtree to get the height of, may be NULL
+/// @return height stored in the root of the subtree, 0 when it's empty
+static int bst_height(bst_node_t *tree) {
+    return tree ? tree->height : 0;
+}
+
+/// @brief Sets height of the node from heights of its subtrees
+/// @param node node whose subtrees have correct heights
+static void bst_update_height(bst_node_t *node) {
+    int left = bst_height(node->left);
+    int right = bst_height(node->right);
+    node->height = (left > right ? left : right) + 1;
+}
+
+/// @brief Rotates the subtree to the right, its left child becomes its root
+/// @param tree subtree to rotate, its left child must exist
+static void bst_rotate_right(bst_node_t **tree) {
+    bst_node_t *root = (*tree)->left;
+    (*tree)->left = root->right;
+    root->right = *tree;
+    bst_update_height(*tree);
+    bst_update_height(root);
+    *tree = root;
+}
+
+/// @brief Rotates the subtree to the left, its right child becomes its root
+/// @param tree subtree to rotate, its right child must exist
+static void bst_rotate_left(bst_node_t **tree) {
+    bst_node_t *root = (*tree)->right;
+    (*tree)->right = root->left;
+    root->left = *tree;
+    bst_update_height(*tree);
+    bst_update_height(root);
+    *tree = root;
+}
+
+/// @brief Restores balance of the subtree after one of its subtrees changed
+///        height by one
+/// @param tree subtree to rebalance, its subtrees must be balanced
+static void bst_rebalance(bst_node_t **tree) {
+    bst_node_t *node = *tree;
+    int balance = bst_height(node->left) - bst_height(node->right);
+
+    // Left subtree is too high, its inner grandchild is moved up first
+    if (balance > 1) {
+        if (bst_height(node->left->left) < bst_height(node->left->right))
+            bst_rotate_left(&node->left);
+        bst_rotate_right(tree);
+    // Right subtree is too high
+    } else if (balance < -1) {
+        if (bst_height(node->right->right) < bst_height(node->right->left))
+            bst_rotate_right(&node->right);
+        bst_rotate_left(tree);
+    } else {
+        bst_update_height(node);
+    }
+}
+
+/*
+ * Inicializace stromu.
+ *
+ * Uživatel musí zajistit, že inicializace se nebude opakovaně volat nad
+ * inicializovaným stromem. V opačném případě může dojít k úniku paměti (memory
+ * leak). Protože neinicializovaný ukazatel má nedefinovanou hodnotu, není
+ * možné toto detekovat ve funkci.
+ */
+void bst_init(bst_node_t **tree) {
+    *tree = NULL;
+}
+
+/*
+ * Vyhledání uzlu v stromu.
+ *
+ * V případě úspěchu vrátí funkce hodnotu true a do proměnné value zapíše
+ * hodnotu daného uzlu. V opačném případě funkce vrátí hodnotu false a proměnná
+ * value zůstává nezměněná.
+ */
+bool bst_search(bst_node_t *tree, char key, int *value) {
+    // Tree is balanced, so the loop runs at most O(log n) times
+    while (tree) {
+        if (tree->key == key) {
+            *value = tree->value;
+            return true;
+        }
+        tree = tree->key < key ? tree->right : tree->left;
+    }
+    // Item wasn't found
+    return false;
+}
+
+/*
+ * Vložení uzlu do stromu.
+ *
+ * Pokud uzel se zadaným klíče už ve stromu existuje, nahraďte jeho hodnotu.
+ * Jinak vložte nový listový uzel a vyvažte všechny uzly na cestě k němu.
+ */
+void bst_insert(bst_node_t **tree, char key, int value) {
+    // Creates new leaf when the key wasn't found
+    if (!(*tree)) {
+        *tree = bst_node_alloc();
+        if (!(*tree))
+            return;
+        (*tree)->key = key;
+        (*tree)->value = value;
+        (*tree)->left = NULL;
+        (*tree)->right = NULL;
+        (*tree)->height = 1;
+        return;
+    }
+
+    // When key equals key of the current node, sets the value, nothing else
+    // changes
+    if ((*tree)->key == key) {
+        (*tree)->value = value;
+        return;
+    }
+    if ((*tree)->key < key)
+        bst_insert(&(*tree)->right, key, value);
+    else
+        bst_insert(&(*tree)->left, key, value);
+    // Subtree may have grown by the new leaf
+    bst_rebalance(tree);
+}
+
+/*
+ * Pomocná funkce která nahradí uzel nejpravějším potomkem.
+ *
+ * Klíč a hodnota uzlu target budou nahrazeny klíčem a hodnotou nejpravějšího
+ * uzlu podstromu tree. Nejpravější potomek bude odstraněný, jeho levý podstrom
+ * zdědí jeho rodič. Uzly na cestě k němu se vyváží.
+ *
+ * Funkce předpokládá, že hodnota tree není NULL.
+ */
+void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
+    if ((*tree)->right) {
+        bst_replace_by_rightmost(target, &(*tree)->right);
+        bst_rebalance(tree);
+        return;
+    }
+    // Replaces target item by the current (rightmost) item
+    target->key = (*tree)->key;
+    target->value = (*tree)->value;
+    bst_node_t *rem = *tree;
+    *tree = rem->left;
+    bst_node_free(rem);
+}
+
+/*
+ * Odstranění uzlu ze stromu.
+ *
+ * Pokud uzel se zadaným klíčem neexistuje, funkce nic nedělá.
+ * Pokud má odstraněný uzel jeden podstrom, zdědí ho rodič odstraněného uzlu.
+ * Pokud má odstraněný uzel oba podstromy, je nahrazený nejpravějším uzlem
+ * levého podstromu. Uzly na cestě k odstraněnému uzlu se vyváží.
+ *
+ * Funkce korektně uvolní všechny alokované zdroje odstraněného uzlu.
+ */
+void bst_delete(bst_node_t **tree, char key) {
+    if (!(*tree))
+        return;
+
+    if ((*tree)->key < key) {
+        bst_delete(&(*tree)->right, key);
+    } else if ((*tree)->key > key) {
+        bst_delete(&(*tree)->left, key);
+    // Node with both subtrees takes key and value of the rightmost node
+    } else if ((*tree)->left && (*tree)->right) {
+        bst_replace_by_rightmost(*tree, &(*tree)->left);
+    // Node with at most one subtree is replaced by it, which is balanced
+    } else {
+        bst_node_t *rem = *tree;
+        *tree = rem->left ? rem->left : rem->right;
+        bst_node_free(rem);
+        return;
+    }
+    // Subtree may have shrunk by the deleted node
+    bst_rebalance(tree);
+}
+
+/*
+ * Zrušení celého stromu.
+ *
+ * Po zrušení se celý strom bude nacházet ve stejném stavu jako po
+ * inicializaci. Funkce korektně uvolní všechny alokované zdroje rušených
+ * uzlů. Hloubka rekurze je omezená výškou vyváženého stromu.
+ */
+void bst_dispose(bst_node_t **tree) {
+    if (!(*tree))
+        return;
+
+    bst_dispose(&(*tree)->left);
+    bst_dispose(&(*tree)->right);
+    bst_node_free(*tree);
+    *tree = NULL;
+}
+
+/*
+ * Preorder průchod stromem.
+ *
+ * Pro aktuálně zpracovávaný uzel zavolejte funkci bst_add_node_to_items.
+ */
+void bst_preorder(bst_node_t *tree, bst_items_t *items) {
+    if (!tree)
+        return;
+
+    // Preorder gets node, left and then right
+    bst_add_node_to_items(tree, items);
+    bst_preorder(tree->left, items);
+    bst_preorder(tree->right, items);
+}
+
+/*
+ * Inorder průchod stromem.
+ *
+ * Pro aktuálně zpracovávaný uzel zavolejte funkci bst_add_node_to_items.
+ */
+void bst_inorder(bst_node_t *tree, bst_items_t *items) {
+    if (!tree)
+        return;
+
+    // Inorder gets left, node and then right
+    bst_inorder(tree->left, items);
+    bst_add_node_to_items(tree, items);
+    bst_inorder(tree->right, items);
+}
+
+/*
+ * Postorder průchod stromem.
+ *
+ * Pro aktuálně zpracovávaný uzel zavolejte funkci bst_add_node_to_items.
+ *
+ * Rekurzivní průchod zásobník nealokuje, vždy vrací true.
+ */
+bool bst_postorder(bst_node_t *tree, bst_items_t *items) {
+    if (!tree)
+        return true;
+
+    // Postorder gets left, right and then node
+    bst_postorder(tree->left, items);
+    bst_postorder(tree->right, items);
+    bst_add_node_to_items(tree, items);
+    return true;
+}
@@ -0,0 +1,173 @@
+/*
+ * Měření rychlosti binárního vyhledávacího stromu.
+ *
+ * Překládá se s každou variantou stromu (make bench v jejím adresáři),
+ * výsledky variant jsou tak přímo srovnatelné. Klíče se vkládají seřazené
+ * i v náhodném pořadí, seřazené klíče nevyvažovaný strom degradují
+ * na lineární seznam. Každé měření se opakuje s uzly z poolu stromu.
+ * Průchod inorder varianty se porovnává s Morrisovým průchodem.
+ */
+
+#define _GNU_SOURCE
+#include "btree.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef BENCH_VARIANT
+#define BENCH_VARIANT "unknown"
+#endif
+
+// Number of distinct keys, all values of char
+#define BENCH_KEYS (CHAR_MAX - CHAR_MIN + 1)
+// Number of times the tree is built, searched and deleted
+#define BENCH_ROUNDS 2000
+// Number of searches of each key in one round
+#define BENCH_SEARCHES 16
+
+/// @brief Gets current time
+/// @return monotonic time in nanoseconds
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/// @brief Gets height of the tree
+/// @param tree tree to measure, may be NULL
+/// @return number of nodes on the longest path from the root
+static int bench_height(bst_node_t *tree) {
+  if (!tree) {
+    return 0;
+  }
+  int left = bench_height(tree->left);
+  int right = bench_height(tree->right);
+  return (left > right ? left : right) + 1;
+}
+
+/// @brief Measures inserts and searches of all keys in given order, deletes
+///        of half of them and dispose of the rest
+/// @param name name of the order
+/// @param keys keys in the order they're inserted and deleted
+/// @param pooled whether the nodes are allocated from pool of the tree
+static void bench_order(const char *name, const char *keys, bool pooled) {
+  double insert = 0, search = 0, delete = 0, dispose = 0;
+  int height = 0;
+  long found = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    // Nodes of the tree without pool are allocated by malloc
+    bst_tree_t tree;
+    bst_tree_init(&tree);
+    bst_node_t *plain;
+    bst_init(&plain);
+    double start = bench_now();
+    for (int i = 0; i < BENCH_KEYS; i++) {
+      if (pooled) {
+        bst_tree_insert(&tree, keys[i], i);
+      } else {
+        bst_insert(&plain, keys[i], i);
+      }
+    }
+    insert += bench_now() - start;
+    bst_node_t *root = pooled ? tree.root : plain;
+    height = bench_height(root);
+
+    start = bench_now();
+    for (int j = 0; j < BENCH_SEARCHES; j++) {
+      for (int i = 0; i < BENCH_KEYS; i++) {
+        int value;
+        found += bst_search(root, keys[i], &value);
+      }
+    }
+    search += bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_KEYS; i += 2) {
+      if (pooled) {
+        bst_tree_delete(&tree, keys[i]);
+      } else {
+        bst_delete(&plain, keys[i]);
+      }
+    }
+    delete += bench_now() - start;
+
+    start = bench_now();
+    if (pooled) {
+      bst_tree_dispose(&tree);
+    } else {
+      bst_dispose(&plain);
+    }
+    dispose += bench_now() - start;
+  }
+
+  double ops = (double)BENCH_ROUNDS * BENCH_KEYS;
+  printf("%-6s %-5s %-8s %8d %12.2f %12.2f %12.2f %12.2f\n", BENCH_VARIANT,
+         pooled ? "pool" : "-", name, height, insert / ops,
+         search / (ops * BENCH_SEARCHES), delete / (ops / 2),
+         dispose / (ops / 2));
+  if (found != (long)BENCH_ROUNDS * BENCH_SEARCHES * BENCH_KEYS) {
+    fprintf(stderr, "lost keys: %ld\n", found);
+  }
+}
+
+/// @brief Measures inorder traversal of the variant against Morris inorder
+/// @param name name of the order
+/// @param keys keys in the order they're inserted
+static void bench_traversal(const char *name, const char *keys) {
+  bst_node_t *tree;
+  bst_init(&tree);
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    bst_insert(&tree, keys[i], i);
+  }
+  // Items keep their capacity between rounds, so only traversal is measured
+  bst_items_t items = {NULL, 0, 0};
+  double inorder = 0, morris = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    items.size = 0;
+    double start = bench_now();
+    bst_inorder(tree, &items);
+    inorder += bench_now() - start;
+    items.size = 0;
+    start = bench_now();
+    bst_morris_inorder(tree, &items);
+    morris += bench_now() - start;
+  }
+  double ops = (double)BENCH_ROUNDS * BENCH_KEYS;
+  printf("%-6s %-8s %12.2f %12.2f\n", BENCH_VARIANT, name, inorder / ops,
+         morris / ops);
+  free(items.nodes);
+  bst_morris_dispose(&tree);
+}
+
+int main(void) {
+  char sorted[BENCH_KEYS];
+  char shuffled[BENCH_KEYS];
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    sorted[i] = shuffled[i] = (char)(CHAR_MIN + i);
+  }
+  // Fisher-Yates shuffle with a fixed seed, so runs are comparable
+  uint64_t state = 0x9e3779b97f4a7c15ull;
+  for (int i = BENCH_KEYS - 1; i > 0; i--) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    int j = (int)((state >> 33) % (uint64_t)(i + 1));
+    char temp = shuffled[i];
+    shuffled[i] = shuffled[j];
+    shuffled[j] = temp;
+  }
+
+  printf("%-6s %-5s %-8s %8s %12s %12s %12s %12s\n", "tree", "nodes",
+         "order", "height", "ns/insert", "ns/search", "ns/delete",
+         "ns/dispose");
+  for (int pooled = 0; pooled < 2; pooled++) {
+    bench_order("sorted", sorted, pooled);
+    bench_order("shuffled", shuffled, pooled);
+  }
+
+  printf("\n%-6s %-8s %12s %12s\n", "tree", "order", "ns/inorder",
+         "ns/morris");
+  bench_traversal("sorted", sorted);
+  bench_traversal("shuffled", shuffled);
+  return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Měření rychlosti B+ stromu proti binárnímu vyhledávacímu stromu.
+ *
+ * Binární strom má uzly se stejným rozložením jako bst_node_t, jen s klíči
+ * typu int, aby se do něj vešlo dost klíčů. Klíče se vkládají v náhodném
+ * pořadí, takže binární strom nedegraduje. Počet klíčů lze zadat jako
+ * argument.
+ */
+
+#define _GNU_SOURCE
+#include "bplus.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Default number of keys in the trees
+#define BENCH_KEYS 1000000
+// Number of lookups of random keys
+#define BENCH_LOOKUPS 2000000
+// Number of full scans
+#define BENCH_SCANS 5
+
+// Node of the binary tree, laid out like bst_node_t
+typedef struct bench_node {
+  int key;                  // key of the node
+  int value;                // value of the node
+  struct bench_node *left;  // subtree with less keys
+  struct bench_node *right; // subtree with greater keys
+} bench_node_t;
+
+/// @brief Gets current time
+/// @return monotonic time in nanoseconds
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/// @brief Generates next pseudo random number
+/// @param state state of the generator
+/// @return next number
+static uint64_t bench_random(uint64_t *state) {
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 33;
+}
+
+/// @brief Inserts key into the binary tree
+/// @param tree root of the tree
+/// @param key key to insert
+/// @param value value of the key
+static void bench_bst_insert(bench_node_t **tree, int key, int value) {
+  while (*tree && (*tree)->key != key) {
+    tree = (*tree)->key < key ? &(*tree)->right : &(*tree)->left;
+  }
+  if (!*tree) {
+    *tree = malloc(sizeof(bench_node_t));
+    (*tree)->key = key;
+    (*tree)->left = (*tree)->right = NULL;
+  }
+  (*tree)->value = value;
+}
+
+/// @brief Searches for key in the binary tree
+/// @param tree root of the tree
+/// @param key key to find
+/// @param visited increased by the number of visited nodes
+/// @return value of the key, -1 when not found
+static int bench_bst_search(bench_node_t *tree, int key, long *visited) {
+  while (tree) {
+    ++*visited;
+    if (tree->key == key) {
+      return tree->value;
+    }
+    tree = tree->key < key ? tree->right : tree->left;
+  }
+  return -1;
+}
+
+/// @brief Sums values of the binary tree in order of keys
+/// @param tree root of the tree
+/// @return sum of the values
+static long bench_bst_scan(bench_node_t *tree) {
+  return tree ? bench_bst_scan(tree->left) + tree->value +
+                    bench_bst_scan(tree->right)
+              : 0;
+}
+
+/// @brief Frees the binary tree
+/// @param tree root of the tree
+static void bench_bst_dispose(bench_node_t *tree) {
+  if (tree) {
+    bench_bst_dispose(tree->left);
+    bench_bst_dispose(tree->right);
+    free(tree);
+  }
+}
+
+/// @brief Adds value of a key to the sum
+/// @param key key of the value
+/// @param value value to add
+/// @param data long sum to add to
+static void bench_sum(int key, int value, void *data) {
+  (void)key;
+  *(long *)data += value;
+}
+
+int main(int argc, char *argv[]) {
+  int count = argc > 1 ? atoi(argv[1]) : BENCH_KEYS;
+  int *keys = malloc(count * sizeof(int));
+  uint64_t state = 0x9e3779b97f4a7c15ull;
+  for (int i = 0; i < count; i++) {
+    keys[i] = (int)bench_random(&state);
+  }
+
+  bench_node_t *bst = NULL;
+  bpt_tree_t bpt;
+  bpt_init(&bpt);
+  double start = bench_now();
+  for (int i = 0; i < count; i++) {
+    bench_bst_insert(&bst, keys[i], i);
+  }
+  double bst_insert = (bench_now() - start) / count;
+  start = bench_now();
+  for (int i = 0; i < count; i++) {
+    bpt_insert(&bpt, keys[i], i);
+  }
+  double bpt_insert = (bench_now() - start) / count;
+
+  // Both trees look up the same random keys
+  long visited = 0, sum = 0;
+  state = 1;
+  start = bench_now();
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    sum += bench_bst_search(bst, keys[bench_random(&state) % count],
+                            &visited);
+  }
+  double bst_search = (bench_now() - start) / BENCH_LOOKUPS;
+  state = 1;
+  start = bench_now();
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    int value = -1;
+    bpt_search(&bpt, keys[bench_random(&state) % count], &value);
+    sum -= value;
+  }
+  double bpt_search = (bench_now() - start) / BENCH_LOOKUPS;
+
+  start = bench_now();
+  for (int i = 0; i < BENCH_SCANS; i++) {
+    sum += bench_bst_scan(bst);
+  }
+  double bst_scan = (bench_now() - start) / BENCH_SCANS / bpt.count;
+  start = bench_now();
+  for (int i = 0; i < BENCH_SCANS; i++) {
+    long scanned = 0;
+    bpt_scan(&bpt, INT_MIN, INT_MAX, bench_sum, &scanned);
+    sum -= scanned;
+  }
+  double bpt_scan_time = (bench_now() - start) / BENCH_SCANS / bpt.count;
+
+  // Each visited node is one dependent load, the B+ tree visits a node on
+  // each level and the leaf
+  printf("%d keys\n", bpt.count);
+  printf("%-6s %12s %12s %12s %12s\n", "tree", "ns/insert", "ns/search",
+         "nodes/search", "ns/scanned");
+  printf("%-6s %12.2f %12.2f %12.2f %12.2f\n", "bst", bst_insert, bst_search,
+         (double)visited / BENCH_LOOKUPS, bst_scan);
+  printf("%-6s %12.2f %12.2f %12.2f %12.2f\n", "bplus", bpt_insert,
+         bpt_search, (double)bpt.height + 1, bpt_scan_time);
+  if (sum != 0) {
+    fprintf(stderr, "trees differ: %ld\n", sum);
+  }
+
+  bench_bst_dispose(bst);
+  bpt_dispose(&bpt);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,387 @@
+/*
+ * B+ strom s uzly velikosti řádků cache
+ *
+ * Každý uzel binárního stromu je samostatně alokovaný a hledání v něm čte
+ * jeden řádek cache na každé úrovni. Uzly B+ stromu mají klíče v jednom
+ * řádku cache a porovnávají se všechny najednou instrukcemi SSE2, strom je
+ * tak mnohem nižší. Hodnoty jsou jen v listech, které jsou propojené, takže
+ * průchod rozsahem klíčů čte najednou celé listy. Při mazání se uzly
+ * neslučují, klíče zůstávají uspořádané i v neúplných listech.
+ */
+
+#include "bplus.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Key of unused slots, greater than any other key
+#define BPT_NONE INT_MAX
+
+/// @brief Compares the key with all keys of a node
+/// @param keys BPT_KEYS keys of the node
+/// @param key key to compare with
+/// @return mask with bit set for each key of the node less than the key
+static inline unsigned bpt_less(const int *keys, int key) {
+#ifdef __SSE2__
+    __m128i wanted = _mm_set1_epi32(key);
+    const __m128i *lines = (const __m128i *)keys;
+    // Four 32 bit masks are packed into 16 byte masks
+    __m128i low = _mm_packs_epi32(_mm_cmplt_epi32(lines[0], wanted),
+                                  _mm_cmplt_epi32(lines[1], wanted));
+    __m128i high = _mm_packs_epi32(_mm_cmplt_epi32(lines[2], wanted),
+                                   _mm_cmplt_epi32(lines[3], wanted));
+    return _mm_movemask_epi8(_mm_packs_epi16(low, high));
+#else
+    unsigned mask = 0;
+    for (int i = 0; i < BPT_KEYS; ++i)
+        mask |= (unsigned)(keys[i] < key) << i;
+    return mask;
+#endif
+}
+
+/// @brief Finds slot of the key in a leaf
+/// @param keys keys of the leaf, sorted and padded by BPT_NONE
+/// @param key key to find
+/// @return number of keys less than the key
+static inline int bpt_lower(const int *keys, int key) {
+    return __builtin_popcount(bpt_less(keys, key));
+}
+
+/// @brief Finds child of inner node whose subtree may contain the key
+/// @param inner node to search in
+/// @param key key to find
+/// @return number of separators less or equal to the key
+static inline int bpt_child(const bpt_inner_t *inner, int key) {
+    // Separator equal to the key is the first key of the right child, only
+    // BPT_NONE can't be incremented, the padding is then cut off
+    if (key == BPT_NONE)
+        return inner->count;
+    return __builtin_popcount(bpt_less(inner->keys, key + 1));
+}
+
+/// @brief Prefetches all lines of a node, so the lines of its children and
+///        values are loaded together with the line of its keys
+/// @param node node to prefetch
+/// @param size size of the node
+static inline void bpt_prefetch(const void *node, size_t size) {
+    for (size_t offset = 0; offset < size; offset += 64)
+        __builtin_prefetch((const char *)node + offset);
+}
+
+/// @brief Allocates empty leaf
+/// @return new leaf, NULL when allocation failed
+static bpt_leaf_t *bpt_leaf_new(void) {
+    bpt_leaf_t *leaf =
+        aligned_alloc(_Alignof(bpt_leaf_t), sizeof(bpt_leaf_t));
+    if (!leaf)
+        return NULL;
+    for (int i = 0; i < BPT_KEYS; ++i)
+        leaf->keys[i] = BPT_NONE;
+    leaf->count = 0;
+    leaf->next = NULL;
+    return leaf;
+}
+
+/// @brief Allocates inner node with single child
+/// @param child the only child of the node
+/// @return new node, NULL when allocation failed
+static bpt_inner_t *bpt_inner_new(void *child) {
+    bpt_inner_t *inner =
+        aligned_alloc(_Alignof(bpt_inner_t), sizeof(bpt_inner_t));
+    if (!inner)
+        return NULL;
+    for (int i = 0; i < BPT_KEYS; ++i)
+        inner->keys[i] = BPT_NONE;
+    inner->count = 0;
+    inner->children[0] = child;
+    return inner;
+}
+
+/// @brief Finds leaf which may contain the key
+/// @param tree non empty tree to search in
+/// @param key key to find
+/// @param path set to inner nodes on the way to the leaf, may be NULL
+/// @param slots set to child taken in each of the nodes, may be NULL
+/// @return the leaf
+static bpt_leaf_t *bpt_find_leaf(bpt_tree_t *tree, int key, bpt_inner_t **path,
+                                 int *slots) {
+    void *node = tree->root;
+    for (int level = 0; level < tree->height; ++level) {
+        bpt_inner_t *inner = node;
+        int slot = bpt_child(inner, key);
+        if (path) {
+            path[level] = inner;
+            slots[level] = slot;
+        }
+        node = inner->children[slot];
+        bpt_prefetch(node, level + 1 < tree->height ? sizeof(bpt_inner_t)
+                                                    : sizeof(bpt_leaf_t));
+    }
+    return node;
+}
+
+/*
+ * Inicializace stromu.
+ */
+void bpt_init(bpt_tree_t *tree) {
+    tree->root = NULL;
+    tree->height = 0;
+    tree->count = 0;
+    tree->first = NULL;
+}
+
+/*
+ * Vyhledání klíče ve stromu.
+ *
+ * V případě úspěchu vrátí funkce hodnotu true a do proměnné value zapíše
+ * hodnotu klíče. V opačném případě vrátí false a value zůstává nezměněná.
+ */
+bool bpt_search(bpt_tree_t *tree, int key, int *value) {
+    if (!tree->root)
+        return false;
+    bpt_leaf_t *leaf = bpt_find_leaf(tree, key, NULL, NULL);
+    int slot = bpt_lower(leaf->keys, key);
+    if (slot >= leaf->count || leaf->keys[slot] != key)
+        return false;
+    *value = leaf->values[slot];
+    return true;
+}
+
+/// @brief Inserts separator and its right child into inner node, splits the
+///        node when it's full
+/// @param inner node to insert to
+/// @param slot index of the separator in the node
+/// @param separator separator to insert, set to separator which has to be
+///        inserted into the parent node after split
+/// @param child right child of the separator, set to the new right node
+///        after split, NULL when the node wasn't split
+/// @param right empty node which becomes the right node after split
+/// @param append whether the node is the rightmost one and the separator is
+///        its last key, the node is then kept full
+static void bpt_inner_insert(bpt_inner_t *inner, int slot, int *separator,
+                             void **child, bpt_inner_t *right, bool append) {
+    if (inner->count < BPT_KEYS) {
+        memmove(&inner->keys[slot + 1], &inner->keys[slot],
+                (inner->count - slot) * sizeof(int));
+        memmove(&inner->children[slot + 2], &inner->children[slot + 1],
+                (inner->count - slot) * sizeof(void *));
+        inner->keys[slot] = *separator;
+        inner->children[slot + 1] = *child;
+        ++inner->count;
+        *child = NULL;
+        return;
+    }
+
+    // Keys and children of the full node with the new ones are split into
+    // two nodes, the middle key moves up
+    int keys[BPT_KEYS + 1];
+    void *children[BPT_KEYS + 2];
+    memcpy(keys, inner->keys, slot * sizeof(int));
+    keys[slot] = *separator;
+    memcpy(&keys[slot + 1], &inner->keys[slot],
+           (BPT_KEYS - slot) * sizeof(int));
+    memcpy(children, inner->children, (slot + 1) * sizeof(void *));
+    children[slot + 1] = *child;
+    memcpy(&children[slot + 2], &inner->children[slot + 1],
+           (BPT_KEYS - slot) * sizeof(void *));
+
+    // Ascending inserts keep the left node full
+    int keep = append ? BPT_KEYS : BPT_KEYS / 2;
+    for (int i = 0; i < BPT_KEYS; ++i)
+        inner->keys[i] = i < keep ? keys[i] : BPT_NONE;
+    memcpy(inner->children, children, (keep + 1) * sizeof(void *));
+    inner->count = keep;
+    right->count = BPT_KEYS - keep;
+    memcpy(right->keys, &keys[keep + 1], right->count * sizeof(int));
+    memcpy(right->children, &children[keep + 1],
+           (right->count + 1) * sizeof(void *));
+    *separator = keys[keep];
+    *child = right;
+}
+
+/// @brief Splits full leaf, its upper keys move to a new leaf
+/// @param leaf leaf to split
+/// @param right empty leaf linked after the leaf
+/// @param append whether all the keys stay in the leaf, because the new key
+///        is greater than any key of the tree
+static void bpt_leaf_split(bpt_leaf_t *leaf, bpt_leaf_t *right, bool append) {
+    int keep = append ? BPT_KEYS : BPT_KEYS / 2;
+    right->count = BPT_KEYS - keep;
+    memcpy(right->keys, &leaf->keys[keep], right->count * sizeof(int));
+    memcpy(right->values, &leaf->values[keep], right->count * sizeof(int));
+    for (int i = keep; i < BPT_KEYS; ++i)
+        leaf->keys[i] = BPT_NONE;
+    leaf->count = keep;
+    right->next = leaf->next;
+    leaf->next = right;
+}
+
+/*
+ * Vložení klíče do stromu.
+ *
+ * Pokud klíč už ve stromu existuje, nahradí se jeho hodnota. Jinak se vloží
+ * do listu, plný list se rozdělí a rozdělení se šíří směrem ke kořeni. Uzly
+ * pro rozdělení se alokují předem, při chybě alokace tak zůstane strom beze
+ * změny.
+ */
+void bpt_insert(bpt_tree_t *tree, int key, int value) {
+    if (!tree->root) {
+        tree->root = tree->first = bpt_leaf_new();
+        if (!tree->root)
+            return;
+    }
+
+    bpt_inner_t *path[BPT_MAX_HEIGHT];
+    int slots[BPT_MAX_HEIGHT];
+    bpt_leaf_t *leaf = bpt_find_leaf(tree, key, path, slots);
+    int slot = bpt_lower(leaf->keys, key);
+    if (slot < leaf->count && leaf->keys[slot] == key) {
+        leaf->values[slot] = value;
+        return;
+    }
+
+    // Full leaf splits all the full inner nodes above it, the root grows
+    // when all of them are full
+    bpt_leaf_t *right = NULL;
+    bpt_inner_t *spare[BPT_MAX_HEIGHT + 1];
+    int splits = 0;
+    if (leaf->count == BPT_KEYS) {
+        while (splits < tree->height &&
+               path[tree->height - 1 - splits]->count == BPT_KEYS)
+            ++splits;
+        int nodes = splits == tree->height ? splits + 1 : splits;
+        if (splits == BPT_MAX_HEIGHT)
+            return;
+        int allocated = 0;
+        right = bpt_leaf_new();
+        while (right && allocated < nodes &&
+               (spare[allocated] = bpt_inner_new(NULL)))
+            ++allocated;
+        if (!right || allocated < nodes) {
+            free(right);
+            while (allocated)
+                free(spare[--allocated]);
+            return;
+        }
+    }
+
+    // Ascending inserts keep the split leaf full
+    bool append = slot == BPT_KEYS && !leaf->next;
+    bpt_leaf_t *target = leaf;
+    if (right) {
+        bpt_leaf_split(leaf, right, append);
+        if (slot > leaf->count || append) {
+            slot -= leaf->count;
+            target = right;
+        }
+    }
+    memmove(&target->keys[slot + 1], &target->keys[slot],
+            (target->count - slot) * sizeof(int));
+    memmove(&target->values[slot + 1], &target->values[slot],
+            (target->count - slot) * sizeof(int));
+    target->keys[slot] = key;
+    target->values[slot] = value;
+    ++target->count;
+    ++tree->count;
+    if (!right)
+        return;
+
+    // Split moves up while the parents are full
+    int separator = right->keys[0];
+    void *child = right;
+    for (int level = tree->height - 1, used = 0; child && level >= 0;
+         --level) {
+        bpt_inner_t *node = path[level]->count == BPT_KEYS ? spare[used++]
+                                                           : NULL;
+        bpt_inner_insert(path[level], slots[level], &separator, &child, node,
+                         append);
+    }
+    if (child) {
+        bpt_inner_t *root = spare[splits];
+        root->keys[0] = separator;
+        root->children[0] = tree->root;
+        root->children[1] = child;
+        root->count = 1;
+        tree->root = root;
+        ++tree->height;
+    }
+}
+
+/*
+ * Odstranění klíče ze stromu.
+ *
+ * Pokud klíč neexistuje, funkce nic nedělá. Listy se neslučují, prázdný list
+ * zůstává ve stromu, dokud se do něj nevloží další klíč.
+ */
+void bpt_delete(bpt_tree_t *tree, int key) {
+    if (!tree->root)
+        return;
+    bpt_leaf_t *leaf = bpt_find_leaf(tree, key, NULL, NULL);
+    int slot = bpt_lower(leaf->keys, key);
+    if (slot >= leaf->count || leaf->keys[slot] != key)
+        return;
+
+    --leaf->count;
+    memmove(&leaf->keys[slot], &leaf->keys[slot + 1],
+            (leaf->count - slot) * sizeof(int));
+    memmove(&leaf->values[slot], &leaf->values[slot + 1],
+            (leaf->count - slot) * sizeof(int));
+    leaf->keys[leaf->count] = BPT_NONE;
+    --tree->count;
+}
+
+/// @brief Frees inner nodes of the subtree
+/// @param node root of the subtree
+/// @param height number of levels of inner nodes in the subtree
+static void bpt_dispose_inner(void *node, int height) {
+    if (!height)
+        return;
+    bpt_inner_t *inner = node;
+    for (int i = 0; i <= inner->count; ++i)
+        bpt_dispose_inner(inner->children[i], height - 1);
+    free(inner);
+}
+
+/*
+ * Zrušení celého stromu.
+ *
+ * Listy se uvolní průchodem jejich seznamem, vnitřní uzly rekurzivně. Po
+ * zrušení je strom ve stejném stavu jako po inicializaci.
+ */
+void bpt_dispose(bpt_tree_t *tree) {
+    bpt_dispose_inner(tree->root, tree->height);
+    for (bpt_leaf_t *leaf = tree->first; leaf;) {
+        bpt_leaf_t *next = leaf->next;
+        free(leaf);
+        leaf = next;
+    }
+    bpt_init(tree);
+}
+
+/*
+ * Průchod rozsahem klíčů.
+ *
+ * Pro každý klíč z intervalu <from, to> zavolá ve vzestupném pořadí funkci
+ * fn. Vrací počet navštívených klíčů.
+ */
+int bpt_scan(bpt_tree_t *tree, int from, int to,
+             void (*fn)(int key, int value, void *data), void *data) {
+    if (!tree->root || from > to)
+        return 0;
+    bpt_leaf_t *leaf = bpt_find_leaf(tree, from, NULL, NULL);
+    int slot = bpt_lower(leaf->keys, from);
+    int visited = 0;
+    for (; leaf; leaf = leaf->next, slot = 0) {
+        for (; slot < leaf->count; ++slot) {
+            if (leaf->keys[slot] > to)
+                return visited;
+            fn(leaf->keys[slot], leaf->values[slot], data);
+            ++visited;
+        }
+    }
+    return visited;
+}
@@ -0,0 +1,47 @@
+/*
+ * Hlavičkový soubor pro B+ strom s uzly velikosti řádků cache.
+ */
+
+#ifndef IAL_BTREE_BPLUS_H
+#define IAL_BTREE_BPLUS_H
+
+#include <stdbool.h>
+
+// Max number of keys in one node, they fill one cache line
+#define BPT_KEYS 16
+// Max height of the tree, inner nodes have at least BPT_KEYS / 2 + 1 children
+// except the rightmost ones
+#define BPT_MAX_HEIGHT 16
+
+// Inner node, its keys are searched by SIMD compares
+typedef struct bpt_inner {
+  _Alignas(64) int keys[BPT_KEYS]; // separators, unused ones are INT_MAX
+  int count;                       // number of separators
+  void *children[BPT_KEYS + 1];    // subtrees, keys of child i + 1 are >= key i
+} bpt_inner_t;
+
+// Leaf node, leaves are linked in order of their keys
+typedef struct bpt_leaf {
+  _Alignas(64) int keys[BPT_KEYS]; // keys, unused ones are INT_MAX
+  int values[BPT_KEYS];            // value of each key
+  int count;                       // number of keys
+  struct bpt_leaf *next;           // leaf with greater keys, NULL for the last
+} bpt_leaf_t;
+
+// B+ strom
+typedef struct bpt_tree {
+  void *root;        // root node, a leaf when height is 0, NULL when empty
+  int height;        // number of levels of inner nodes
+  int count;         // number of keys in the tree
+  bpt_leaf_t *first; // leaf with the least keys, start of full scans
+} bpt_tree_t;
+
+void bpt_init(bpt_tree_t *tree);
+void bpt_insert(bpt_tree_t *tree, int key, int value);
+bool bpt_search(bpt_tree_t *tree, int key, int *value);
+void bpt_delete(bpt_tree_t *tree, int key);
+void bpt_dispose(bpt_tree_t *tree);
+int bpt_scan(bpt_tree_t *tree, int from, int to,
+             void (*fn)(int key, int value, void *data), void *data);
+
+#endif
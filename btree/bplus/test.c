@@ -0,0 +1,120 @@
+#include "bplus.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST(NAME, DESCRIPTION)                                                \
+  void NAME() {                                                                \
+    printf("[%s] %s\n", #NAME, DESCRIPTION);                                   \
+    bpt_tree_t test_tree;                                                      \
+    bpt_init(&test_tree);
+
+#define ENDTEST                                                                \
+  printf("\n");                                                                \
+  bpt_dispose(&test_tree);                                                     \
+  }
+
+// Number of keys of tests with many keys, enough for three levels
+#define TEST_MANY 10000
+
+void bpt_print_pair(int key, int value, void *data) {
+  (void)data;
+  printf("[%d,%d]", key, value);
+}
+
+void bpt_count_pair(int key, int value, void *data) {
+  (void)key;
+  (void)value;
+  ++*(int *)data;
+}
+
+void bpt_print_search(bpt_tree_t *tree, int key) {
+  int value;
+  if (bpt_search(tree, key, &value)) {
+    printf("%d: %d\n", key, value);
+  } else {
+    printf("%d: not found\n", key);
+  }
+}
+
+TEST(test_search_empty, "Search in an empty tree")
+bpt_print_search(&test_tree, 1);
+printf("Scanned: %d\n", bpt_scan(&test_tree, INT_MIN, INT_MAX,
+                                 bpt_print_pair, NULL));
+ENDTEST
+
+TEST(test_insert_few, "Insert and update keys of one leaf")
+const int keys[] = {8, 4, 12, 2, 6, 10, 14, INT_MAX, INT_MIN};
+for (int i = 0; i < 9; i++)
+  bpt_insert(&test_tree, keys[i], i);
+bpt_insert(&test_tree, 6, 60);
+printf("Count: %d, height: %d\n", test_tree.count, test_tree.height);
+bpt_print_search(&test_tree, 6);
+bpt_print_search(&test_tree, INT_MAX);
+bpt_print_search(&test_tree, INT_MIN);
+bpt_print_search(&test_tree, 7);
+bpt_scan(&test_tree, INT_MIN, INT_MAX, bpt_print_pair, NULL);
+printf("\n");
+ENDTEST
+
+TEST(test_insert_ascending, "Insert ascending keys, leaves stay full")
+for (int i = 0; i < TEST_MANY; i++)
+  bpt_insert(&test_tree, i, i * 2);
+int leaves = 0;
+for (bpt_leaf_t *leaf = test_tree.first; leaf; leaf = leaf->next)
+  leaves++;
+printf("Count: %d, height: %d, leaves: %d\n", test_tree.count,
+       test_tree.height, leaves);
+bpt_print_search(&test_tree, 0);
+bpt_print_search(&test_tree, 5000);
+bpt_print_search(&test_tree, TEST_MANY);
+ENDTEST
+
+TEST(test_insert_random, "Insert and delete keys in random order")
+// Values of the keys are tracked in an array, 0 when the key is missing
+static int expected[TEST_MANY];
+unsigned state = 1;
+for (int i = 0; i < 5 * TEST_MANY; i++) {
+  state = state * 1103515245 + 12345;
+  int key = (state >> 8) % TEST_MANY;
+  if (i % 3 == 2) {
+    bpt_delete(&test_tree, key);
+    expected[key] = 0;
+  } else {
+    bpt_insert(&test_tree, key, i + 1);
+    expected[key] = i + 1;
+  }
+}
+int count = 0, wrong = 0;
+for (int key = 0; key < TEST_MANY; key++) {
+  int value = 0;
+  bool found = bpt_search(&test_tree, key, &value);
+  count += found;
+  wrong += found != (expected[key] != 0) || value != expected[key];
+}
+int scanned = 0;
+bpt_scan(&test_tree, INT_MIN, INT_MAX, bpt_count_pair, &scanned);
+printf("Count: %d, found: %d, scanned: %d, wrong: %d\n", test_tree.count,
+       count, scanned, wrong);
+ENDTEST
+
+TEST(test_scan_range, "Scan a range of keys across leaves")
+for (int i = 0; i < 100; i++)
+  bpt_insert(&test_tree, i * 10, i);
+bpt_delete(&test_tree, 300);
+printf("Scanned: %d\n", bpt_scan(&test_tree, 255, 345, bpt_print_pair, NULL));
+printf("Scanned: %d\n", bpt_scan(&test_tree, 991, 2000, bpt_print_pair,
+                                 NULL));
+ENDTEST
+
+int main(int argc, char *argv[]) {
+  printf("B+ Tree - testing script\n");
+  printf("------------------------\n");
+  printf("\n");
+
+  test_search_empty();
+  test_insert_few();
+  test_insert_ascending();
+  test_insert_random();
+  test_scan_range();
+}
@@ -20,4 +20,206 @@ void bst_add_node_to_items(bst_node_t* node, bst_items_t *items) {
   }
   items->nodes[items->size] = node;
   items->size++;
-}
\ No newline at end of file
+}
+
+/// @brief Finds inorder predecessor of the node within its left subtree
+/// @param node node with left subtree
+/// @return rightmost node of the left subtree, or the last node before the
+///         one whose right pointer is threaded back to node
+static bst_node_t *bst_morris_predecessor(bst_node_t *node) {
+  bst_node_t *pred = node->left;
+  while (pred->right && pred->right != node)
+    pred = pred->right;
+  return pred;
+}
+
+/*
+ * Inorder průchod stromem s konstantní pamětí (Morrisův průchod).
+ *
+ * Místo zásobníku se nejpravější uzel levého podstromu dočasně napojí
+ * ukazatelem right na svého následníka. Při druhé návštěvě uzlu se vazba
+ * zruší, po průchodu je strom ve stejném stavu jako před ním. Funkce
+ * nealokuje, její paměť nezávisí na hloubce stromu.
+ */
+void bst_morris_inorder(bst_node_t *tree, bst_items_t *items) {
+  while (tree) {
+    if (!tree->left) {
+      bst_add_node_to_items(tree, items);
+      tree = tree->right;
+      continue;
+    }
+    bst_node_t *pred = bst_morris_predecessor(tree);
+    // First visit threads the predecessor back to the node
+    if (!pred->right) {
+      pred->right = tree;
+      tree = tree->left;
+    // Second visit, left subtree is done, so the thread is removed
+    } else {
+      pred->right = NULL;
+      bst_add_node_to_items(tree, items);
+      tree = tree->right;
+    }
+  }
+}
+
+/*
+ * Preorder průchod stromem s konstantní pamětí (Morrisův průchod).
+ *
+ * Stejné dočasné vazby jako u bst_morris_inorder, uzel se ale zpracuje
+ * při první návštěvě.
+ */
+void bst_morris_preorder(bst_node_t *tree, bst_items_t *items) {
+  while (tree) {
+    if (!tree->left) {
+      bst_add_node_to_items(tree, items);
+      tree = tree->right;
+      continue;
+    }
+    bst_node_t *pred = bst_morris_predecessor(tree);
+    if (!pred->right) {
+      bst_add_node_to_items(tree, items);
+      pred->right = tree;
+      tree = tree->left;
+    } else {
+      pred->right = NULL;
+      tree = tree->right;
+    }
+  }
+}
+
+/*
+ * Zrušení celého stromu s konstantní pamětí.
+ *
+ * Levý potomek uzlu se rotací doprava přesouvá nad něj, dokud uzel nemá levý
+ * podstrom. Pak se uzel uvolní a pokračuje se pravým podstromem. Každá
+ * rotace přesune jeden uzel na pravou páteř, počet kroků je tak lineární.
+ */
+void bst_morris_dispose(bst_node_t **tree) {
+  bst_node_t *node = *tree;
+  while (node) {
+    if (node->left) {
+      bst_node_t *left = node->left;
+      node->left = left->right;
+      left->right = node;
+      node = left;
+    } else {
+      bst_node_t *right = node->right;
+      bst_node_free(node);
+      node = right;
+    }
+  }
+  *tree = NULL;
+}
+
+// Pool of the tree which is being changed by bst_tree_ functions, nodes are
+// allocated by malloc when it's NULL
+static _Thread_local bst_pool_t *bst_active_pool = NULL;
+
+/// @brief Allocates node, from the active pool when there's one
+/// @return new node, NULL when allocation failed
+bst_node_t *bst_node_alloc(void) {
+  bst_pool_t *pool = bst_active_pool;
+  if (!pool) {
+    bst_node_t *node = malloc(sizeof(bst_node_t));
+    if (node)
+      node->pooled = false;
+    return node;
+  }
+
+  // Deleted nodes are reused first
+  if (pool->free_nodes) {
+    bst_node_t *node = pool->free_nodes;
+    pool->free_nodes = node->left;
+    return node;
+  }
+  // New slab is twice as big as the previous one
+  if (!pool->slabs || pool->slab_used == pool->slabs->capacity) {
+    int capacity = pool->slabs ? pool->slabs->capacity * 2 : BST_SLAB_MIN;
+    if (capacity > BST_SLAB_MAX)
+      capacity = BST_SLAB_MAX;
+    bst_slab_t *slab =
+        malloc(sizeof(bst_slab_t) + capacity * sizeof(bst_node_t));
+    if (!slab)
+      return NULL;
+    slab->next = pool->slabs;
+    slab->capacity = capacity;
+    pool->slabs = slab;
+    pool->slab_used = 0;
+  }
+  bst_node_t *node = &pool->slabs->nodes[pool->slab_used++];
+  node->pooled = true;
+  return node;
+}
+
+/// @brief Frees node to the place it was allocated from
+///
+/// Node of a pool freed while no pool is active (by bst_ function called on
+/// root of a tree with a pool) can't be returned to its pool, it's left in
+/// its slab, which is freed by bst_tree_dispose.
+///
+/// @param node node allocated by bst_node_alloc
+void bst_node_free(bst_node_t *node) {
+  if (!node->pooled) {
+    free(node);
+    return;
+  }
+  if (bst_active_pool) {
+    node->left = bst_active_pool->free_nodes;
+    bst_active_pool->free_nodes = node;
+  }
+}
+
+/*
+ * Inicializace stromu s poolem uzlů.
+ */
+void bst_tree_init(bst_tree_t *tree) {
+  bst_init(&tree->root);
+  tree->pool.slabs = NULL;
+  tree->pool.slab_used = 0;
+  tree->pool.free_nodes = NULL;
+}
+
+/*
+ * Vložení uzlu do stromu s poolem, uzel se alokuje z poolu stromu.
+ */
+void bst_tree_insert(bst_tree_t *tree, char key, int value) {
+  bst_active_pool = &tree->pool;
+  bst_insert(&tree->root, key, value);
+  bst_active_pool = NULL;
+}
+
+/*
+ * Odstranění uzlu ze stromu s poolem, uzel se vrátí do poolu stromu.
+ */
+void bst_tree_delete(bst_tree_t *tree, char key) {
+  bst_active_pool = &tree->pool;
+  bst_delete(&tree->root, key);
+  bst_active_pool = NULL;
+}
+
+#ifdef EXA
+/*
+ * Vyvážení stromu s poolem, nové uzly se alokují z poolu stromu a staré se
+ * do něj vrátí.
+ */
+void bst_tree_balance(bst_tree_t *tree) {
+  bst_active_pool = &tree->pool;
+  bst_balance(&tree->root);
+  bst_active_pool = NULL;
+}
+#endif
+
+/*
+ * Zrušení stromu s poolem.
+ *
+ * Uzly se neprocházejí, uvolní se jen bloky paměti poolu. Po zrušení je strom
+ * ve stejném stavu jako po inicializaci.
+ */
+void bst_tree_dispose(bst_tree_t *tree) {
+  while (tree->pool.slabs) {
+    bst_slab_t *next = tree->pool.slabs->next;
+    free(tree->pool.slabs);
+    tree->pool.slabs = next;
+  }
+  bst_tree_init(tree);
+}
@@ -11,11 +11,53 @@
 // Uzel stromu
 typedef struct bst_node {
   char key;               // klíč
+  bool pooled;            // whether the node belongs to a pool of a tree
   int value;              // hodnota
   struct bst_node *left;  // levý potomek
   struct bst_node *right; // pravý potomek
+#ifdef BST_AVL
+  int height;             // výška podstromu, list má výšku 1
+#endif
 } bst_node_t;
 
+// Number of nodes in the first slab, each next slab is twice as big
+#define BST_SLAB_MIN 16
+// Max number of nodes in one slab
+#define BST_SLAB_MAX 4096
+
+// Blok paměti, ze kterého se alokují uzly jednoho stromu
+typedef struct bst_slab {
+  struct bst_slab *next; // previously allocated slab
+  int capacity;          // number of nodes in the slab
+  bst_node_t nodes[];    // nodes of the slab
+} bst_slab_t;
+
+// Pool of nodes of one tree, nodes allocated together are adjacent
+typedef struct bst_pool {
+  bst_slab_t *slabs;      // slabs of nodes, the newest first
+  int slab_used;          // number of nodes ever used in the newest slab
+  bst_node_t *free_nodes; // deleted nodes linked by left, reused first
+} bst_pool_t;
+
+// Strom s uzly alokovanými z vlastního poolu. Uzly do poolu alokují
+// a vracejí funkce bst_tree_. Uzel poolu uvolněný jinou funkcí bst_ se
+// nevrací do malloc, zůstane v poolu až do bst_tree_dispose.
+typedef struct bst_tree {
+  bst_node_t *root; // root of the tree
+  bst_pool_t pool;  // pool of the nodes
+} bst_tree_t;
+
+bst_node_t *bst_node_alloc(void);
+void bst_node_free(bst_node_t *node);
+
+void bst_tree_init(bst_tree_t *tree);
+void bst_tree_insert(bst_tree_t *tree, char key, int value);
+void bst_tree_delete(bst_tree_t *tree, char key);
+void bst_tree_dispose(bst_tree_t *tree);
+#ifdef EXA
+void bst_tree_balance(bst_tree_t *tree);
+#endif
+
 void bst_init(bst_node_t **tree);
 void bst_insert(bst_node_t **tree, char key, int value);
 bool bst_search(bst_node_t *tree, char key, int *value);
@@ -33,7 +75,11 @@ void bst_add_node_to_items(bst_node_t* node, bst_items_t *items);
 
 void bst_preorder(bst_node_t *tree, bst_items_t *items);
 void bst_inorder(bst_node_t *tree, bst_items_t *items);
-void bst_postorder(bst_node_t *tree, bst_items_t *items);
+bool bst_postorder(bst_node_t *tree, bst_items_t *items);
+
+void bst_morris_inorder(bst_node_t *tree, bst_items_t *items);
+void bst_morris_preorder(bst_node_t *tree, bst_items_t *items);
+void bst_morris_dispose(bst_node_t **tree);
 
 void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree);
 
@@ -82,7 +82,7 @@ void bst_insert(bst_node_t **tree, char key, int value) {
     }
 
     // Creates new item -> item with given key doesn't exist in the tree
-    *node = malloc(sizeof(bst_node_t));
+    *node = bst_node_alloc();
     if (!(*node))
         return;
     (*node)->key = key;
@@ -113,7 +113,7 @@ void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
     target->key = (*node)->key;
     target->value = (*node)->value;
     // Frees the rightmost node
-    free(*node);
+    bst_node_free(*node);
     *node = NULL;
 }
 
@@ -138,7 +138,7 @@ void bst_delete(bst_node_t **tree, char key) {
         if ((*node)->key == key) {
             // Node doesn't have any subtrees
             if (!(*node)->right && !(*node)->left) {
-                free(*node);
+                bst_node_free(*node);
                 *node = NULL;
             // Node has both subtrees
             } else if ((*node)->right && (*node)->left) {
@@ -147,12 +147,12 @@ void bst_delete(bst_node_t **tree, char key) {
             } else if ((*node)->right) {
                 bst_node_t *rem = *node;
                 *node = (*node)->right;
-                free(rem);
+                bst_node_free(rem);
             // Node has left subtree only
             } else {
                 bst_node_t *rem = *node;
                 *node = (*node)->left;
-                free(rem);
+                bst_node_free(rem);
             }
         }
         // Goes to right subtree when current key is less then given key
@@ -173,6 +173,8 @@ void bst_delete(bst_node_t **tree, char key) {
  *
  * Funkci implementujte iterativně s pomocí zásobníku a bez použití
  * vlastních pomocných funkcí.
+ *
+ * Podstrom, který se nevejde do zásobníku, se zruší bez zásobníku.
  */
 void bst_dispose(bst_node_t **tree) {
     // Checks if tree is NULL
@@ -189,15 +191,17 @@ void bst_dispose(bst_node_t **tree) {
     while (!stack_bst_empty(&stack)) {
         // Gets item from the stack
         *tree = stack_bst_pop(&stack);
-        // Pushes right subnode to stack if exists
-        if ((*tree)->right)
-            stack_bst_push(&stack, (*tree)->right);
+        // Pushes right subnode to stack if exists, disposes it without
+        // stack when the stack can't grow
+        if ((*tree)->right && !stack_bst_push(&stack, (*tree)->right))
+            bst_morris_dispose(&(*tree)->right);
         // Pushes left subnode to stack if exists
-        if ((*tree)->left)
-            stack_bst_push(&stack, (*tree)->left);
+        if ((*tree)->left && !stack_bst_push(&stack, (*tree)->left))
+            bst_morris_dispose(&(*tree)->left);
         // Frees current item
-        free(*tree);
+        bst_node_free(*tree);
     }
+    stack_bst_dispose(&stack);
 
     // Sets tree to NULL
     *tree = NULL;
@@ -211,13 +215,17 @@ void bst_dispose(bst_node_t **tree) {
  *
  * Funkci implementujte iterativně s pomocí zásobníku a bez použití
  * vlastních pomocných funkcí.
+ *
+ * Vrací false, pokud se zásobník nepodařilo zvětšit.
  */
-void bst_leftmost_preorder(bst_node_t *tree, stack_bst_t *to_visit, bst_items_t *items) {
+bool bst_leftmost_preorder(bst_node_t *tree, stack_bst_t *to_visit, bst_items_t *items) {
     // Iterates to the leftmost node
     for (; tree; tree = tree->left) {
-        stack_bst_push(to_visit, tree);
+        if (!stack_bst_push(to_visit, tree))
+            return false;
         bst_add_node_to_items(tree, items);
     }
+    return true;
 }
 
 /*
@@ -227,21 +235,32 @@ void bst_leftmost_preorder(bst_node_t *tree, stack_bst_t *to_visit, bst_items_t
  *
  * Funkci implementujte iterativně pomocí funkce bst_leftmost_preorder a
  * zásobníku uzlů a bez použití vlastních pomocných funkcí.
+ *
+ * Pokud se zásobník nepodaří zvětšit, přidané uzly se zahodí a celý průchod
+ * se provede znovu funkcí bst_morris_preorder, která zásobník nepotřebuje.
  */
 void bst_preorder(bst_node_t *tree, bst_items_t *items) {
     // Creates new stack
     stack_bst_t to_visit;
     stack_bst_init(&to_visit);
 
-    bst_leftmost_preorder(tree, &to_visit, items);
+    int size = items->size;
+    bool pushed = bst_leftmost_preorder(tree, &to_visit, items);
     bst_node_t *node = NULL;
-    // Iterates until stack is not empty
-    while (!stack_bst_empty(&to_visit)) {
+    // Iterates until stack is not empty or it can't grow
+    while (pushed && !stack_bst_empty(&to_visit)) {
         // Gets item from stack
         node = stack_bst_pop(&to_visit);
         // When right subtree exists, call bst_leftmost_preorder
         if (node->right)
-            bst_leftmost_preorder(node->right, &to_visit, items);
+            pushed = bst_leftmost_preorder(node->right, &to_visit, items);
+    }
+    stack_bst_dispose(&to_visit);
+
+    // Stack couldn't grow, traverses the tree again without it
+    if (!pushed) {
+        items->size = size;
+        bst_morris_preorder(tree, items);
     }
 }
 
@@ -253,12 +272,16 @@ void bst_preorder(bst_node_t *tree, bst_items_t *items) {
  *
  * Funkci implementujte iterativně s pomocí zásobníku a bez použití
  * vlastních pomocných funkcí.
+ *
+ * Vrací false, pokud se zásobník nepodařilo zvětšit.
  */
-void bst_leftmost_inorder(bst_node_t *tree, stack_bst_t *to_visit) {
+bool bst_leftmost_inorder(bst_node_t *tree, stack_bst_t *to_visit) {
     // Iterates to the leftmost node
     for (; tree; tree = tree->left) {
-        stack_bst_push(to_visit, tree);
+        if (!stack_bst_push(to_visit, tree))
+            return false;
     }
+    return true;
 }
 
 /*
@@ -268,23 +291,34 @@ void bst_leftmost_inorder(bst_node_t *tree, stack_bst_t *to_visit) {
  *
  * Funkci implementujte iterativně pomocí funkce bst_leftmost_inorder a
  * zásobníku uzlů a bez použití vlastních pomocných funkcí.
+ *
+ * Pokud se zásobník nepodaří zvětšit, přidané uzly se zahodí a celý průchod
+ * se provede znovu funkcí bst_morris_inorder, která zásobník nepotřebuje.
  */
 void bst_inorder(bst_node_t *tree, bst_items_t *items) {
     // Creates new stack
     stack_bst_t to_visit;
     stack_bst_init(&to_visit);
 
-    bst_leftmost_inorder(tree, &to_visit);
+    int size = items->size;
+    bool pushed = bst_leftmost_inorder(tree, &to_visit);
     bst_node_t *node = NULL;
-    // Iterates until stack is not empty
-    while (!stack_bst_empty(&to_visit)) {
+    // Iterates until stack is not empty or it can't grow
+    while (pushed && !stack_bst_empty(&to_visit)) {
         // Gets item from the stack
         node = stack_bst_pop(&to_visit);
         // Adds current item to final list
         bst_add_node_to_items(node, items);
         // When right subtree exists, calls bst_leftmost_inorder
         if (node->right)
-            bst_leftmost_inorder(node->right, &to_visit);
+            pushed = bst_leftmost_inorder(node->right, &to_visit);
+    }
+    stack_bst_dispose(&to_visit);
+
+    // Stack couldn't grow, traverses the tree again without it
+    if (!pushed) {
+        items->size = size;
+        bst_morris_inorder(tree, items);
     }
 }
 
@@ -297,14 +331,18 @@ void bst_inorder(bst_node_t *tree, bst_items_t *items) {
  *
  * Funkci implementujte iterativně pomocí zásobníku uzlů a bool hodnot a bez použití
  * vlastních pomocných funkcí.
+ *
+ * Vrací false, pokud se zásobník nepodařilo zvětšit.
  */
-void bst_leftmost_postorder(bst_node_t *tree, stack_bst_t *to_visit,
+bool bst_leftmost_postorder(bst_node_t *tree, stack_bst_t *to_visit,
                             stack_bool_t *first_visit) {
     // Iterates to the leftmost node
     for (; tree; tree = tree->left) {
-        stack_bool_push(first_visit, true);
-        stack_bst_push(to_visit, tree);
+        if (!stack_bool_push(first_visit, true) ||
+            !stack_bst_push(to_visit, tree))
+            return false;
     }
+    return true;
 }
 
 /*
@@ -314,18 +352,22 @@ void bst_leftmost_postorder(bst_node_t *tree, stack_bst_t *to_visit,
  *
  * Funkci implementujte iterativně pomocí funkce bst_leftmost_postorder a
  * zásobníku uzlů a bool hodnot a bez použití vlastních pomocných funkcí.
+ *
+ * Vrací false, pokud se zásobník nepodařilo zvětšit. Průchod pak skončí
+ * předčasně a přidané uzly se zahodí.
  */
-void bst_postorder(bst_node_t *tree, bst_items_t *items) {
+bool bst_postorder(bst_node_t *tree, bst_items_t *items) {
     // Creates new stack for items to visit and for bool values
     stack_bst_t to_visit;
     stack_bst_init(&to_visit);
     stack_bool_t first_visit;
     stack_bool_init(&first_visit);
 
-    bst_leftmost_postorder(tree, &to_visit, &first_visit);
+    int size = items->size;
+    bool pushed = bst_leftmost_postorder(tree, &to_visit, &first_visit);
     bst_node_t *node = NULL;
-    // Iterates until stack is not empty
-    while (!stack_bst_empty(&to_visit)) {
+    // Iterates until stack is not empty or it can't grow
+    while (pushed && !stack_bst_empty(&to_visit)) {
         // Gets item from the stack
         node = stack_bst_top(&to_visit);
 
@@ -334,7 +376,8 @@ void bst_postorder(bst_node_t *tree, bst_items_t *items) {
             // Sets first_visit to false and call bst_leftmost_postorder
             // for right subtree
             stack_bool_push(&first_visit, false);
-            bst_leftmost_postorder(node->right, &to_visit, &first_visit);
+            pushed = bst_leftmost_postorder(node->right, &to_visit,
+                                            &first_visit);
         // Item was already visited
         } else {
             // Adds current item to the final list and pops from items to visit
@@ -342,4 +385,11 @@ void bst_postorder(bst_node_t *tree, bst_items_t *items) {
             stack_bst_pop(&to_visit);
         }
     }
+    stack_bst_dispose(&to_visit);
+    stack_bool_dispose(&first_visit);
+
+    // Postorder has no traversal without stack, the failure is reported
+    if (!pushed)
+        items->size = size;
+    return pushed;
 }
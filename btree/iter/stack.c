@@ -4,20 +4,37 @@
  */
 #include "stack.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*
  * Makro generující implementaci funkcí pracujících se zásobníky.
  * Podrobnější popis zásobníků v stack.h.
  */
 #define STACKDEF(T, TNAME)                                                     \
-  void stack_##TNAME##_init(stack_##TNAME##_t *stack) { stack->top = -1; }     \
+  void stack_##TNAME##_init(stack_##TNAME##_t *stack) {                        \
+    stack->items = stack->small;                                               \
+    stack->capacity = STACK_SMALL;                                             \
+    stack->top = -1;                                                           \
+  }                                                                            \
                                                                                \
-  void stack_##TNAME##_push(stack_##TNAME##_t *stack, T item) {                \
-    if (stack->top == MAXSTACK - 1) {                                          \
-      printf("[W] Stack overflow\n");                                          \
-    } else {                                                                   \
-      stack->items[++stack->top] = item;                                       \
+  bool stack_##TNAME##_push(stack_##TNAME##_t *stack, T item) {                \
+    if (stack->top == stack->capacity - 1) {                                   \
+      /* Full stack moves to heap array twice as big */                        \
+      T *items = stack->items == stack->small                                  \
+                     ? malloc(2 * stack->capacity * sizeof(T))                 \
+                     : realloc(stack->items, 2 * stack->capacity * sizeof(T)); \
+      if (!items) {                                                            \
+        return false;                                                          \
+      }                                                                        \
+      if (stack->items == stack->small) {                                      \
+        memcpy(items, stack->small, sizeof(stack->small));                     \
+      }                                                                        \
+      stack->items = items;                                                    \
+      stack->capacity *= 2;                                                    \
     }                                                                          \
+    stack->items[++stack->top] = item;                                         \
+    return true;                                                               \
   }                                                                            \
                                                                                \
   T stack_##TNAME##_top(stack_##TNAME##_t *stack) {                            \
@@ -37,6 +54,13 @@
                                                                                \
   bool stack_##TNAME##_empty(stack_##TNAME##_t *stack) {                       \
     return stack->top == -1;                                                   \
+  }                                                                            \
+                                                                               \
+  void stack_##TNAME##_dispose(stack_##TNAME##_t *stack) {                     \
+    if (stack->items != stack->small) {                                        \
+      free(stack->items);                                                      \
+    }                                                                          \
+    stack_##TNAME##_init(stack);                                               \
   }
 
 STACKDEF(bst_node_t*, bst)
@@ -7,31 +7,39 @@
 
 #include "../btree.h"
 
-// Maximální velikost zásobníku
-#define MAXSTACK 30
+// Počet položek, které se vejdou do zásobníku bez alokace
+#define STACK_SMALL 32
 
 /*
  * Makro generující deklarace pro zásobník typu T s názvovým infixem TNAME.
+ * Položky jsou nejdřív v poli small uvnitř zásobníku, při jeho zaplnění se
+ * přesunou na haldu do pole dvojnásobné velikosti, které se dál zdvojnásobuje.
  * Pro TNAME="bst" pracující s typem T="bst_node_t*":
  *   Datový typ stack_bst_t
  *   Funkce void stack_bst_init(stack_bst_t *stack)
- *           void stack_bst_push(stack_bst_t *stack, bst_node_t *item)
+ *           bool stack_bst_push(stack_bst_t *stack, bst_node_t *item)
  *           bst_node_t *stack_bst_pop(stack_bst_t *stack)
  *           bst_node_t *stack_bst_top(stack_bst_t *stack)
  *           bool stack_bst_empty(stack_bst_t *stack)
+ *           void stack_bst_dispose(stack_bst_t *stack)
  * A ekvivalent pro TNAME="bool", T="bool".
+ * Push vrací false, pokud se zásobník nepodařilo zvětšit, položka se pak
+ * nevloží.
  */
 #define STACKDEC(T, TNAME)                                                     \
   typedef struct {                                                             \
-    T items[MAXSTACK];                                                         \
-    int top;                                                                   \
+    T small[STACK_SMALL]; /* items until the stack outgrows it */              \
+    T *items;             /* small or heap array of capacity items */          \
+    int capacity;         /* number of items which fit to items */             \
+    int top;              /* index of the top item, -1 when empty */           \
   } stack_##TNAME##_t;                                                         \
                                                                                \
   void stack_##TNAME##_init(stack_##TNAME##_t *stack);                         \
-  void stack_##TNAME##_push(stack_##TNAME##_t *stack, T item);                 \
+  bool stack_##TNAME##_push(stack_##TNAME##_t *stack, T item);                 \
   T stack_##TNAME##_pop(stack_##TNAME##_t *stack);                             \
   T stack_##TNAME##_top(stack_##TNAME##_t *stack);                             \
-  bool stack_##TNAME##_empty(stack_##TNAME##_t *stack);
+  bool stack_##TNAME##_empty(stack_##TNAME##_t *stack);                        \
+  void stack_##TNAME##_dispose(stack_##TNAME##_t *stack);
 
 STACKDEC(bst_node_t *, bst)
 STACKDEC(bool, bool)
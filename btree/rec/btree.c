@@ -62,7 +62,7 @@ void bst_insert(bst_node_t **tree, char key, int value) {
     // Checks if tree is NULL
     if (!tree || !(*tree)) {
         // Creates new tree item with given key and value
-        *tree = malloc(sizeof(bst_node_t));
+        *tree = bst_node_alloc();
         if (!(*tree))
             return;
         (*tree)->key = key;
@@ -105,7 +105,7 @@ void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
     target->key = (*tree)->key;
     target->value = (*tree)->value;
     // Frees current item
-    free(*tree);
+    bst_node_free(*tree);
     *tree = NULL;
 }
 
@@ -131,7 +131,7 @@ void bst_delete(bst_node_t **tree, char key) {
     if ((*tree)->key == key) {
         // Removes current item, which doesn't contain any subtree
         if (!(*tree)->right && !(*tree)->left) {
-            free(*tree);
+            bst_node_free(*tree);
             *tree = NULL;
         }
         // Removes current item, which contains both subtrees
@@ -141,12 +141,12 @@ void bst_delete(bst_node_t **tree, char key) {
         else if ((*tree)->right) {
             bst_node_t *rem = *tree;
             *tree = (*tree)->right;
-            free(rem);
+            bst_node_free(rem);
         // Removes current item, which includes left subtree only
         } else {
             bst_node_t *rem = *tree;
             *tree = (*tree)->left;
-            free(rem);
+            bst_node_free(rem);
         }
     // Recursively calls for right subtree when key is greater then current key
     } else if ((*tree)->key < key) {
@@ -175,7 +175,7 @@ void bst_dispose(bst_node_t **tree) {
     bst_dispose(&(*tree)->left);
     bst_dispose(&(*tree)->right);
     // Frees current node
-    free(*tree);
+    bst_node_free(*tree);
     *tree = NULL;
 }
 
@@ -221,14 +221,17 @@ void bst_inorder(bst_node_t *tree, bst_items_t *items) {
  * Pro aktuálně zpracovávaný uzel zavolejte funkci bst_add_node_to_items.
  *
  * Funkci implementujte rekurzivně bez použití vlastních pomocných funkcí.
+ *
+ * Rekurzivní průchod zásobník nealokuje, vždy vrací true.
  */
-void bst_postorder(bst_node_t *tree, bst_items_t *items) {
+bool bst_postorder(bst_node_t *tree, bst_items_t *items) {
     // Checks if tree is null
     if (!tree)
-        return;
+        return true;
 
     // Postorder gets left, right and then node
     bst_postorder(tree->left, items);
     bst_postorder(tree->right, items);
     bst_add_node_to_items(tree, items);
+    return true;
 }
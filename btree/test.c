@@ -1,5 +1,6 @@
 #include "btree.h"
 #include "test_util.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -168,13 +169,130 @@ ENDTEST
 TEST(test_tree_postorder, "Traverse the tree using postorder")
 bst_init(&test_tree);
 bst_insert_many(&test_tree, traversal_keys, traversal_values, traversal_data_count);
-bst_postorder(test_tree, test_items);
+bool complete = bst_postorder(test_tree, test_items);
+bst_print_tree(test_tree);
+bst_print_items(test_items);
+printf("Complete: %s\n", complete ? "true" : "false");
+ENDTEST
+
+TEST(test_tree_morris_preorder, "Traverse the tree using Morris preorder")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, traversal_keys, traversal_values, traversal_data_count);
+bst_morris_preorder(test_tree, test_items);
+bst_print_tree(test_tree);
+bst_print_items(test_items);
+ENDTEST
+
+TEST(test_tree_morris_inorder, "Traverse the tree using Morris inorder")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, traversal_keys, traversal_values, traversal_data_count);
+bst_morris_inorder(test_tree, test_items);
+bst_print_tree(test_tree);
+bst_print_items(test_items);
+ENDTEST
+
+TEST(test_tree_morris_dispose, "Dispose the whole tree without a stack")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_morris_dispose(&test_tree);
 bst_print_tree(test_tree);
+ENDTEST
+
+TEST(test_tree_deep, "Traverse a deep tree of all sorted keys")
+bst_init(&test_tree);
+// Unbalanced tree makes every node the right child of the previous one
+for (int key = CHAR_MIN; key <= CHAR_MAX; key++)
+  bst_insert(&test_tree, (char)key, key);
+bst_inorder(test_tree, test_items);
+printf("Inorder: %d", test_items->size);
+bst_reset_items(test_items);
+bst_postorder(test_tree, test_items);
+printf(", postorder: %d, first: %d", test_items->size,
+       test_items->nodes[0]->value);
+bst_reset_items(test_items);
+bst_preorder(test_tree, test_items);
+printf(", preorder: %d\n", test_items->size);
+bst_reset_items(test_items);
+bst_morris_inorder(test_tree, test_items);
+printf("Morris inorder: %d", test_items->size);
+bst_reset_items(test_items);
+bst_morris_preorder(test_tree, test_items);
+printf(", preorder: %d\n", test_items->size);
+bst_morris_dispose(&test_tree);
+ENDTEST
+
+TEST(test_tree_pool, "Insert, delete and dispose nodes of a pool")
+bst_init(&test_tree);
+bst_tree_t pooled;
+bst_tree_init(&pooled);
+for (int i = 0; i < base_data_count; i++)
+  bst_tree_insert(&pooled, base_keys[i], base_values[i]);
+// Deleted nodes are reused by the next inserts
+bst_tree_delete(&pooled, 'L');
+bst_tree_delete(&pooled, 'A');
+bst_tree_insert(&pooled, 'P', 17);
+bst_tree_insert(&pooled, 'Q', 18);
+bst_print_tree(pooled.root);
+bst_inorder(pooled.root, test_items);
 bst_print_items(test_items);
+printf("Free nodes: %s, used: %d\n", pooled.pool.free_nodes ? "yes" : "no",
+       pooled.pool.slab_used);
+bst_tree_dispose(&pooled);
+printf("Empty: %s\n", pooled.root || pooled.pool.slabs ? "no" : "yes");
+ENDTEST
+
+TEST(test_tree_pool_dispose, "Dispose a pool after deleting most of its nodes")
+bst_init(&test_tree);
+bst_tree_t pooled;
+bst_tree_init(&pooled);
+// Sorted keys fill more than one slab, deleted nodes of all of them are
+// on the free list when the pool is disposed
+for (int key = CHAR_MIN; key <= CHAR_MAX; key++)
+  bst_tree_insert(&pooled, (char)key, key);
+for (int key = CHAR_MIN; key <= CHAR_MAX; key += 3)
+  bst_tree_delete(&pooled, (char)key);
+bst_inorder(pooled.root, test_items);
+int slabs = 0;
+for (bst_slab_t *slab = pooled.pool.slabs; slab; slab = slab->next)
+  slabs++;
+printf("Items: %d, slabs: %d", test_items->size, slabs);
+bst_tree_dispose(&pooled);
+printf(", empty: %s\n", pooled.root || pooled.pool.slabs ? "no" : "yes");
+ENDTEST
+
+TEST(test_tree_pool_plain, "Delete and dispose nodes of a pool without it")
+bst_init(&test_tree);
+bst_tree_t pooled;
+bst_tree_init(&pooled);
+for (int i = 0; i < base_data_count; i++)
+  bst_tree_insert(&pooled, base_keys[i], base_values[i]);
+// Node allocated by malloc is freed by bst_tree_delete
+bst_insert(&pooled.root, 'P', 17);
+bst_tree_delete(&pooled, 'P');
+// Nodes of the pool stay in it until the pool is disposed
+bst_delete(&pooled.root, 'L');
+bst_inorder(pooled.root, test_items);
+bst_print_items(test_items);
+bst_dispose(&pooled.root);
+bst_tree_dispose(&pooled);
+printf("Empty: %s\n", pooled.root || pooled.pool.slabs ? "no" : "yes");
 ENDTEST
 
 #ifdef EXA
 
+TEST(test_tree_pool_balance, "Count letters and balance a tree with a pool")
+bst_init(&test_tree);
+bst_tree_t pooled;
+bst_tree_init(&pooled);
+const char *input = "abBcCc_ 123 *";
+for (int i = 0; input[i]; i++)
+  bst_tree_insert(&pooled, input[i], i);
+bst_tree_balance(&pooled);
+bst_print_tree(pooled.root);
+printf("Free nodes: %s\n", pooled.pool.free_nodes ? "yes" : "no");
+bst_tree_dispose(&pooled);
+ENDTEST
+
 TEST(test_letter_count, "Count letters");
 bst_init(&test_tree);
 letter_count(&test_tree, "abBcCc_ 123 *");
@@ -219,10 +337,18 @@ int main(int argc, char *argv[]) {
   test_tree_preorder();
   test_tree_inorder();
   test_tree_postorder();
+  test_tree_morris_preorder();
+  test_tree_morris_inorder();
+  test_tree_morris_dispose();
+  test_tree_deep();
+  test_tree_pool();
+  test_tree_pool_dispose();
+  test_tree_pool_plain();
 
 #ifdef EXA
   test_letter_count();
   test_balance();
   test_balance_real();
+  test_tree_pool_balance();
 #endif // EXA
 }
@@ -77,6 +77,7 @@ void bst_reset_items (bst_items_t *items) {
     {
       free(items->nodes);
     }
+    items->nodes = NULL;
     items->capacity = 0;
     items->size = 0;
   }
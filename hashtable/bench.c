@@ -0,0 +1,842 @@
+/*
+ * Měření výkonu tabulky s rozptýlenými položkami.
+ *
+ * Měří vkládání, vyhledávání a mazání nad několika druhy klíčů a velikostmi
+ * tabulky. Výsledky vypisuje jako tabulku a zároveň je ukládá ve formátu CSV
+ * (výchozí soubor bench.csv, případně první argument), aby bylo možné
+ * porovnávat jednotlivé verze.
+ */
+
+#define _GNU_SOURCE
+
+#include "hashtable.h"
+#include "hashtable_frozen.h"
+#include "hashtable_shared.h"
+#include "hashtable_typed.h"
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Sizes of the measured tables
+static const int BENCH_SIZES[] = {1000, 65536, 1000000};
+#define BENCH_SIZE_COUNT (int)(sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]))
+// Max number of items of measured table
+#define BENCH_MAX_ITEMS 1000000
+// Length of buffer of each generated key
+#define BENCH_KEY 64
+// Every BENCH_SAMPLE-th operation is timed alone for latency percentiles
+#define BENCH_SAMPLE 16
+// Exponent of the Zipfian distribution
+#define BENCH_ZIPF 0.99
+
+// Number of keys looked up at once, like in one request
+#define BENCH_REQUEST 256
+// Number of requests measured
+#define BENCH_REQUESTS 20000
+// Share of lookups of the filter benchmark which are for missing keys
+#define BENCH_MISSES 0.8
+// Number of operations done by each thread on the shared table
+#define BENCH_SHARED_OPS 2000000
+// Max number of threads using the shared table
+#define BENCH_THREADS 16
+
+#ifdef HT_SWISS
+#define BENCH_BACKEND "swiss"
+#else
+#define BENCH_BACKEND "chain"
+#endif
+
+// Kinds of generated key sets
+typedef enum bench_keys {
+  BENCH_UNIFORM,    // random ids, looked up uniformly
+  BENCH_ZIPFIAN,    // random ids, few of them looked up much more often
+  BENCH_SEQUENTIAL, // sequential ids
+  BENCH_URL,        // long keys looking like URLs
+  BENCH_KEYS_COUNT,
+} bench_keys_t;
+
+static const char *BENCH_KEYS_NAMES[] = {"uniform", "zipfian", "sequential",
+                                         "url"};
+
+// Result of measuring one operation
+typedef struct bench_result {
+  double ns;     // average time of the operation in nanoseconds
+  double p50;    // median latency in nanoseconds
+  double p99;    // 99th percentile of latency in nanoseconds
+  double allocs; // number of allocations per operation
+  double misses; // number of cache misses per operation
+  bool measured; // whether misses come from hardware counter or estimate
+} bench_result_t;
+
+// Work of one thread using the shared table
+typedef struct bench_worker {
+  pthread_t thread;        // thread doing the work
+  ht_shared_t *table;      // table shared by all the threads
+  char (*keys)[BENCH_KEY]; // keys to work with
+  uint64_t seed;           // seed of the keys sequence
+} bench_worker_t;
+
+// Number of allocations done by the table, counted by wrapped malloc
+static size_t bench_allocs = 0;
+// File descriptor of hardware cache misses counter, -1 when not available
+static int bench_perf = -1;
+// Time spent by reading the clock, subtracted from sampled latencies
+static double bench_overhead = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  ++bench_allocs;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  ++bench_allocs;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size) {
+  ++bench_allocs;
+  return __real_aligned_alloc(alignment, size);
+}
+
+/// @brief Gets current time in nanoseconds
+/// @return monotonic time in nanoseconds
+static double bench_now() {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+/// @brief Generates pseudo random number
+/// @param state state of the generator, changed by each call
+/// @return generated number
+static uint64_t bench_random(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+/// @brief Opens hardware counter of cache misses of this process
+static void bench_perf_open() {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  bench_perf = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/// @brief Reads the cache misses counter
+/// @return number of cache misses so far, 0 when not available
+static uint64_t bench_perf_read() {
+  uint64_t count = 0;
+  if (bench_perf >= 0 && read(bench_perf, &count, sizeof(count)) < 0)
+    count = 0;
+  return count;
+}
+
+/// @brief Measures how long reading the clock takes
+static void bench_calibrate() {
+  double min = 1e9;
+  for (int i = 0; i < 1000; i++) {
+    double start = bench_now();
+    double time = bench_now() - start;
+    min = time < min ? time : min;
+  }
+  bench_overhead = min;
+}
+
+/// @brief Compares two doubles for qsort
+static int bench_compare(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/// @brief Generates keys of given kind
+/// @param kind kind of the keys
+/// @param keys buffer for BENCH_MAX_ITEMS keys
+static void bench_generate(bench_keys_t kind, char (*keys)[BENCH_KEY]) {
+  uint64_t state = 0x9e3779b97f4a7c15ull;
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    uint64_t random = bench_random(&state);
+    switch (kind) {
+    case BENCH_SEQUENTIAL:
+      snprintf(keys[i], BENCH_KEY, "%d", i);
+      break;
+    case BENCH_URL:
+      snprintf(keys[i], BENCH_KEY, "https://example.com/u/%u/posts/%d?ref=%x",
+               (unsigned)(random % 100000), i, (unsigned)(random >> 40));
+      break;
+    default:
+      snprintf(keys[i], BENCH_KEY, "%016llx", (unsigned long long)random);
+      break;
+    }
+  }
+}
+
+/// @brief Generates order in which keys are looked up
+/// @param kind kind of the keys
+/// @param order set to indexes of looked up keys
+/// @param count number of inserted keys and of lookups
+static void bench_order(bench_keys_t kind, int *order, int count) {
+  uint64_t state = 0x2545f4914f6cdd1dull;
+  if (kind != BENCH_ZIPFIAN) {
+    for (int i = 0; i < count; i++) {
+      order[i] = bench_random(&state) % count;
+    }
+    return;
+  }
+
+  // Zipfian ranks are sampled from cumulative distribution by bisection
+  double *cdf = malloc(count * sizeof(double));
+  double sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += 1 / pow(i + 1, BENCH_ZIPF);
+    cdf[i] = sum;
+  }
+  for (int i = 0; i < count; i++) {
+    double u = (bench_random(&state) >> 11) * 0x1p-53 * sum;
+    int low = 0;
+    int high = count - 1;
+    while (low < high) {
+      int mid = (low + high) / 2;
+      if (cdf[mid] < u)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    order[i] = low;
+  }
+  free(cdf);
+}
+
+/// @brief Estimates cache misses per operation when there is no counter
+///
+/// Each list head or group of control bytes and each probed item is counted
+/// as one missed cache line.
+///
+/// @param table measured table
+/// @param op index of the operation: 0 insert, 1 get, 2 delete
+/// @return estimated number of cache misses per operation
+static double bench_estimate(ht_table_t *table, int op) {
+  ht_stats_t stats;
+  ht_stats(table, &stats);
+#ifdef HT_COUNTERS
+  if (stats.counters.searches)
+    return 1 + (double)stats.counters.probes / stats.counters.searches;
+#endif
+#ifdef HT_SWISS
+  // Control bytes, slot and key stored outside of the slot
+  return 3;
+#else
+  // Insert searches whole list, others stop in the middle on average
+  return 1 + (op == 0 ? stats.load : 1 + stats.load / 2);
+#endif
+}
+
+/// @brief Measures one operation over all the keys
+/// @param table table to do the operation on
+/// @param op index of the operation: 0 insert, 1 get, 2 delete
+/// @param keys keys of the items
+/// @param order indexes of keys for lookups
+/// @param count number of operations
+/// @param latencies buffer for sampled latencies
+/// @return measured result
+static bench_result_t bench_op(ht_table_t *table, int op,
+                               char (*keys)[BENCH_KEY], int *order, int count,
+                               double *latencies) {
+  bench_result_t result;
+  size_t allocs = bench_allocs;
+  uint64_t misses = bench_perf_read();
+  // Lookups and deletes are estimated from the table they started with
+  double estimate = op == 0 ? 0 : bench_estimate(table, op);
+  double sum = 0;
+  double elapsed = 0;
+  int samples = 0;
+
+  for (int i = 0; i < count; i += BENCH_SAMPLE) {
+    int end = i + BENCH_SAMPLE < count ? i + BENCH_SAMPLE : count;
+    // First operation of the block is timed alone, others together
+    double start = bench_now();
+    for (int j = i; j < end; j++) {
+      if (j == i + 1) {
+        latencies[samples++] = bench_now() - start - bench_overhead;
+      }
+      if (op == 0) {
+        ht_insert(table, keys[j], j);
+      } else if (op == 1) {
+        float *value = ht_get(table, keys[order[j]]);
+        sum += value ? *value : 0;
+      } else {
+        ht_delete(table, keys[j]);
+      }
+    }
+    if (end == i + 1) {
+      latencies[samples++] = bench_now() - start - bench_overhead;
+    }
+    elapsed += bench_now() - start;
+  }
+
+  result.ns = elapsed / count;
+  result.allocs = (double)(bench_allocs - allocs) / count;
+  result.measured = bench_perf >= 0;
+  result.misses = result.measured
+                      ? (double)(bench_perf_read() - misses) / count
+                      : op == 0 ? bench_estimate(table, op) : estimate;
+  qsort(latencies, samples, sizeof(double), bench_compare);
+  result.p50 = latencies[samples / 2];
+  result.p99 = latencies[samples * 99 / 100];
+  // Sum is printed so the lookups can't be optimized out
+  if (sum == 1.5) {
+    fprintf(stderr, "checksum: %f\n", sum);
+  }
+  return result;
+}
+
+/// @brief Measures insert, get and delete for all key sets and table sizes
+/// @param csv file for machine readable results
+static void bench_suite(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(BENCH_MAX_ITEMS * sizeof(*keys));
+  int *order = malloc(BENCH_MAX_ITEMS * sizeof(int));
+  double *latencies = malloc(BENCH_MAX_ITEMS * sizeof(double));
+  const char *ops[] = {"insert", "get", "delete"};
+
+  printf("%-11s %8s %-7s %9s %9s %9s %8s %8s\n", "keys", "items", "op",
+         "ns/op", "p50", "p99", "allocs", "misses");
+  for (int kind = 0; kind < BENCH_KEYS_COUNT; kind++) {
+    bench_generate(kind, keys);
+    for (int s = 0; s < BENCH_SIZE_COUNT; s++) {
+      int count = BENCH_SIZES[s];
+      bench_order(kind, order, count);
+
+      ht_table_t table;
+      ht_init(&table);
+      for (int op = 0; op < 3; op++) {
+        bench_result_t result =
+            bench_op(&table, op, keys, order, count, latencies);
+        printf("%-11s %8d %-7s %9.1f %9.1f %9.1f %8.3f %7.2f%s\n",
+               BENCH_KEYS_NAMES[kind], count, ops[op], result.ns, result.p50,
+               result.p99, result.allocs, result.misses,
+               result.measured ? "" : "*");
+        fprintf(csv, "%s,%s,%d,%s,%.2f,%.2f,%.2f,%.4f,%.3f,%s\n",
+                BENCH_BACKEND, BENCH_KEYS_NAMES[kind], count, ops[op],
+                result.ns, result.p50, result.p99, result.allocs,
+                result.misses, result.measured ? "hw" : "estimate");
+      }
+      ht_delete_all(&table);
+    }
+  }
+  if (bench_perf < 0) {
+    printf("* estimated, hardware counter of cache misses isn't available\n");
+  }
+
+  free(latencies);
+  free(order);
+  free(keys);
+}
+
+/// @brief Compares per key ht_get with batched ht_get_many
+/// @param csv file for machine readable results
+static void bench_batch(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(2 * BENCH_MAX_ITEMS * sizeof(*keys));
+  char **request = malloc(BENCH_REQUEST * sizeof(char *));
+  float **values = malloc(BENCH_REQUEST * sizeof(float *));
+
+  // Second half of the keys is never inserted, so it's looked up as misses
+  for (int i = 0; i < 2 * BENCH_MAX_ITEMS; i++) {
+    snprintf(keys[i], BENCH_KEY, "user:%08x:%d", i * 2654435761u, i);
+  }
+  ht_table_t table;
+  ht_init(&table);
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    ht_insert(&table, keys[i], i);
+  }
+
+  printf("\n%-12s %12s %12s\n", "method", "ns/key", "Mkeys/s");
+  const char *methods[] = {"ht_get", "ht_get_many"};
+  for (int method = 0; method < 2; method++) {
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    double sum = 0;
+    double elapsed = 0;
+    for (int r = 0; r < BENCH_REQUESTS; r++) {
+      // Half of the keys of each request are hits
+      for (int i = 0; i < BENCH_REQUEST; i++) {
+        request[i] = keys[bench_random(&state) % (2 * BENCH_MAX_ITEMS)];
+      }
+
+      double start = bench_now();
+      if (method == 0) {
+        for (int i = 0; i < BENCH_REQUEST; i++) {
+          values[i] = ht_get(&table, request[i]);
+        }
+      } else {
+        ht_get_many(&table, request, BENCH_REQUEST, values);
+      }
+      elapsed += bench_now() - start;
+
+      for (int i = 0; i < BENCH_REQUEST; i++) {
+        sum += values[i] ? *values[i] : 0;
+      }
+    }
+
+    double per_key = elapsed / ((double)BENCH_REQUESTS * BENCH_REQUEST);
+    printf("%-12s %12.2f %12.2f\n", methods[method], per_key, 1e3 / per_key);
+    fprintf(csv, "%s,batch,%d,%s,%.2f,,,,,\n", BENCH_BACKEND,
+            BENCH_MAX_ITEMS, methods[method], per_key);
+    if (sum == 1.5) {
+      fprintf(stderr, "checksum: %f\n", sum);
+    }
+  }
+
+  ht_delete_all(&table);
+  free(values);
+  free(request);
+  free(keys);
+}
+/// @brief Measures ht_get on mostly missing keys without and with the filter
+/// @param csv file for machine readable results
+static void bench_filter(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(2 * BENCH_MAX_ITEMS * sizeof(*keys));
+  // Second half of the keys is never inserted, so it's looked up as misses
+  for (int i = 0; i < 2 * BENCH_MAX_ITEMS; i++) {
+    snprintf(keys[i], BENCH_KEY, "user:%08x:%d", i * 2654435761u, i);
+  }
+  ht_table_t table;
+  ht_init(&table);
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    ht_insert(&table, keys[i], i);
+  }
+
+  printf("\n%-12s %12s %12s %12s\n", "filter", "ns/get", "Mgets/s",
+         "fp rate");
+  const double rates[] = {0, 0.01};
+  const char *methods[] = {"ht_get", "ht_get_filtered"};
+  for (int method = 0; method < 2; method++) {
+    ht_set_filter(&table, rates[method]);
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    int lookups = BENCH_REQUESTS * BENCH_REQUEST;
+    double sum = 0;
+    double start = bench_now();
+    for (int i = 0; i < lookups; i++) {
+      uint64_t random = bench_random(&state);
+      int index = random % BENCH_MAX_ITEMS;
+      // Random bits above the index choose whether it's a miss
+      if ((random >> 40) % 100 < BENCH_MISSES * 100)
+        index += BENCH_MAX_ITEMS;
+      float *value = ht_get(&table, keys[index]);
+      sum += value ? *value : 0;
+    }
+    double per_get = (bench_now() - start) / lookups;
+
+    ht_stats_t stats;
+    ht_stats(&table, &stats);
+    // Rate is measured on the missing keys, hits always pass
+    uint64_t misses = stats.filter.false_positives + stats.filter.rejects;
+    double rate = misses ? (double)stats.filter.false_positives / misses : 0;
+    printf("%-12s %12.2f %12.2f %12.4f\n",
+           rates[method] > 0 ? "blocked" : "none", per_get, 1e3 / per_get,
+           rate);
+    fprintf(csv, "%s,misses,%d,%s,%.2f,,,,,\n", BENCH_BACKEND,
+            BENCH_MAX_ITEMS, methods[method], per_get);
+    if (sum == 1.5) {
+      fprintf(stderr, "checksum: %f\n", sum);
+    }
+  }
+
+  ht_delete_all(&table);
+  free(keys);
+}
+
+/// @brief Measures counting of keys by ht_get followed by ht_insert and by
+///        ht_accumulate
+/// @param csv file for machine readable results
+static void bench_accumulate(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(BENCH_MAX_ITEMS * sizeof(*keys));
+  bench_generate(BENCH_URL, keys);
+
+  printf("\n%-16s %12s %12s\n", "counter", "ns/add", "Madds/s");
+  const char *methods[] = {"get_insert", "ht_accumulate"};
+  for (int method = 0; method < 2; method++) {
+    ht_table_t table;
+    ht_init(&table);
+    // Keys repeat, so most of the adds find their key
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    int adds = BENCH_REQUESTS * BENCH_REQUEST;
+    double start = bench_now();
+    for (int i = 0; i < adds; i++) {
+      char *key = keys[bench_random(&state) % (BENCH_MAX_ITEMS / 4)];
+      if (method == 0) {
+        float *value = ht_get(&table, key);
+        ht_insert(&table, key, value ? *value + 1 : 1);
+      } else {
+        ht_accumulate(&table, key, 1);
+      }
+    }
+    double per_add = (bench_now() - start) / adds;
+    printf("%-16s %12.2f %12.2f\n", methods[method], per_add, 1e3 / per_add);
+    fprintf(csv, "%s,counters,%d,%s,%.2f,,,,,\n", BENCH_BACKEND,
+            BENCH_MAX_ITEMS / 4, methods[method], per_add);
+    ht_delete_all(&table);
+  }
+  free(keys);
+}
+
+/// @brief Measures lookups of integer ids by the table specialized for int
+///        keys and by the string table with ids formatted into keys
+/// @param csv file for machine readable results
+static void bench_typed(FILE *csv) {
+  ht_table_t table;
+  ht_int_t ints;
+  ht_init(&table);
+  ht_int_init(&ints);
+  char key[BENCH_KEY];
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    snprintf(key, BENCH_KEY, "%d", i);
+    ht_insert(&table, key, i);
+    ht_int_insert(&ints, i, i);
+  }
+
+  printf("\n%-12s %12s %12s\n", "int keys", "ns/get", "Mgets/s");
+  const char *methods[] = {"ht_get", "ht_int_get"};
+  for (int method = 0; method < 2; method++) {
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    int lookups = BENCH_REQUESTS * BENCH_REQUEST;
+    double sum = 0;
+    double start = bench_now();
+    for (int i = 0; i < lookups; i++) {
+      int id = bench_random(&state) % BENCH_MAX_ITEMS;
+      float *value;
+      if (method == 0) {
+        snprintf(key, BENCH_KEY, "%d", id);
+        value = ht_get(&table, key);
+      } else {
+        value = ht_int_get(&ints, id);
+      }
+      sum += value ? *value : 0;
+    }
+    double per_get = (bench_now() - start) / lookups;
+    printf("%-12s %12.2f %12.2f\n", methods[method], per_get, 1e3 / per_get);
+    fprintf(csv, "%s,ids,%d,%s,%.2f,,,,,\n", BENCH_BACKEND, BENCH_MAX_ITEMS,
+            methods[method], per_get);
+    if (sum == 1.5) {
+      fprintf(stderr, "checksum: %f\n", sum);
+    }
+  }
+
+  ht_int_delete_all(&ints);
+  ht_delete_all(&table);
+}
+
+/// @brief Measures aggregation of all values of the table
+/// @param csv file for machine readable results
+static void bench_aggregate(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(BENCH_MAX_ITEMS * sizeof(*keys));
+  bench_generate(BENCH_UNIFORM, keys);
+  ht_table_t table;
+  ht_init(&table);
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    ht_insert(&table, keys[i], i);
+  }
+
+  printf("\n%-12s %12s %12s\n", "aggregate", "ns/value", "Mvalues/s");
+  const int rounds = 20;
+  double start = bench_now();
+  double sum = 0;
+  for (int r = 0; r < rounds; r++) {
+    sum += ht_sum(&table);
+  }
+  double per_value = (bench_now() - start) / rounds / BENCH_MAX_ITEMS;
+  printf("%-12s %12.3f %12.2f\n", "ht_sum", per_value, 1e3 / per_value);
+  fprintf(csv, "%s,aggregate,%d,ht_sum,%.3f,,,,,\n", BENCH_BACKEND,
+          BENCH_MAX_ITEMS, per_value);
+  if (sum == 1.5) {
+    fprintf(stderr, "checksum: %f\n", sum);
+  }
+
+  ht_delete_all(&table);
+  free(keys);
+}
+
+/// @brief Does 90 % lookups and 10 % inserts on the shared table
+/// @param arg bench_worker_t of the thread
+/// @return NULL
+static void *bench_shared_worker(void *arg) {
+  bench_worker_t *worker = arg;
+  uint64_t state = worker->seed;
+  float value;
+  for (int i = 0; i < BENCH_SHARED_OPS; i++) {
+    uint64_t random = bench_random(&state);
+    char *key = worker->keys[(random >> 8) % BENCH_MAX_ITEMS];
+    if (random % 10 == 0) {
+      ht_shared_insert(worker->table, key, i);
+    } else {
+      ht_shared_get(worker->table, key, &value);
+    }
+  }
+  return NULL;
+}
+
+/// @brief Measures throughput of the shared table with growing thread count
+/// @param csv file for machine readable results
+static void bench_shared(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(BENCH_MAX_ITEMS * sizeof(*keys));
+  bench_generate(BENCH_UNIFORM, keys);
+  ht_shared_t table;
+  ht_shared_init(&table, 256);
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    ht_shared_insert(&table, keys[i], i);
+  }
+
+  printf("\n%-12s %12s %12s\n", "threads", "Mops/s", "speedup");
+  bench_worker_t workers[BENCH_THREADS];
+  double single = 0;
+  for (int threads = 1; threads <= BENCH_THREADS; threads *= 2) {
+    double start = bench_now();
+    for (int i = 0; i < threads; i++) {
+      workers[i].table = &table;
+      workers[i].keys = keys;
+      workers[i].seed = 0x9e3779b97f4a7c15ull * (i + 1);
+      pthread_create(&workers[i].thread, NULL, bench_shared_worker,
+                     &workers[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+      pthread_join(workers[i].thread, NULL);
+    }
+    double ops = (double)threads * BENCH_SHARED_OPS;
+    double mops = ops / (bench_now() - start) * 1e3;
+    if (threads == 1) {
+      single = mops;
+    }
+    printf("%-12d %12.2f %12.2f\n", threads, mops, mops / single);
+    fprintf(csv, "%s,shared,%d,threads_%d,%.2f,,,,,\n", BENCH_BACKEND,
+            BENCH_MAX_ITEMS, threads, 1e3 / mops);
+  }
+
+  ht_shared_delete_all(&table);
+  free(keys);
+}
+
+/// @brief Measures build of frozen table and its lookups compared with the
+///        table it was built from
+/// @param csv file for machine readable results
+static void bench_frozen(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(BENCH_MAX_ITEMS * sizeof(*keys));
+  bench_generate(BENCH_UNIFORM, keys);
+  ht_table_t table;
+  ht_init(&table);
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    ht_insert(&table, keys[i], i);
+  }
+
+  ht_frozen_t frozen;
+  double start = bench_now();
+  ht_freeze(&table, &frozen);
+  double build = (bench_now() - start) / BENCH_MAX_ITEMS;
+  ht_stats_t stats;
+  ht_stats(&table, &stats);
+
+  printf("\n%-12s %12s %12s %12s\n", "frozen", "ns/get", "Mgets/s",
+         "bytes/key");
+  const char *methods[] = {"ht_get", "ht_frozen_get"};
+  for (int method = 0; method < 2; method++) {
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    int lookups = BENCH_REQUESTS * BENCH_REQUEST;
+    double sum = 0;
+    start = bench_now();
+    for (int i = 0; i < lookups; i++) {
+      char *key = keys[bench_random(&state) % BENCH_MAX_ITEMS];
+      float *value =
+          method == 0 ? ht_get(&table, key) : ht_frozen_get(&frozen, key);
+      sum += value ? *value : 0;
+    }
+    double per_get = (bench_now() - start) / lookups;
+    size_t memory = method == 0 ? stats.memory : ht_frozen_memory(&frozen);
+    printf("%-12s %12.2f %12.2f %12.1f\n", methods[method], per_get,
+           1e3 / per_get, (double)memory / BENCH_MAX_ITEMS);
+    fprintf(csv, "%s,frozen,%d,%s,%.2f,,,,,\n", BENCH_BACKEND,
+            BENCH_MAX_ITEMS, methods[method], per_get);
+    if (sum == 1.5) {
+      fprintf(stderr, "checksum: %f\n", sum);
+    }
+  }
+  printf("%-12s %12.2f\n", "ht_freeze", build);
+  fprintf(csv, "%s,frozen,%d,ht_freeze,%.2f,,,,,\n", BENCH_BACKEND,
+          BENCH_MAX_ITEMS, build);
+
+  ht_frozen_free(&frozen);
+  ht_delete_all(&table);
+  free(keys);
+}
+
+/// @brief Measures lookups of keys which are slices of one buffer, copied
+///        into zero terminated keys or used in place
+/// @param csv file for machine readable results
+static void bench_slices(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(BENCH_MAX_ITEMS * sizeof(*keys));
+  bench_generate(BENCH_URL, keys);
+  ht_table_t table;
+  ht_init(&table);
+  // Keys are joined by spaces like in a received request
+  char *buffer = malloc(BENCH_MAX_ITEMS * BENCH_KEY);
+  size_t *starts = malloc(BENCH_MAX_ITEMS * sizeof(size_t));
+  size_t *lengths = malloc(BENCH_MAX_ITEMS * sizeof(size_t));
+  size_t used = 0;
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    ht_insert(&table, keys[i], i);
+    starts[i] = used;
+    lengths[i] = strlen(keys[i]);
+    memcpy(buffer + used, keys[i], lengths[i]);
+    used += lengths[i];
+    buffer[used++] = ' ';
+  }
+
+  printf("\n%-12s %12s %12s\n", "slices", "ns/get", "Mgets/s");
+  const char *methods[] = {"strndup_get", "ht_get_n"};
+  for (int method = 0; method < 2; method++) {
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    int lookups = BENCH_REQUESTS * BENCH_REQUEST;
+    double sum = 0;
+    double start = bench_now();
+    for (int i = 0; i < lookups; i++) {
+      int index = bench_random(&state) % BENCH_MAX_ITEMS;
+      const char *slice = buffer + starts[index];
+      float *value;
+      if (method == 0) {
+        char *key = strndup(slice, lengths[index]);
+        value = ht_get(&table, key);
+        free(key);
+      } else {
+        value = ht_get_n(&table, slice, lengths[index]);
+      }
+      sum += value ? *value : 0;
+    }
+    double per_get = (bench_now() - start) / lookups;
+    printf("%-12s %12.2f %12.2f\n", methods[method], per_get, 1e3 / per_get);
+    fprintf(csv, "%s,slices,%d,%s,%.2f,,,,,\n", BENCH_BACKEND,
+            BENCH_MAX_ITEMS, methods[method], per_get);
+    if (sum == 1.5) {
+      fprintf(stderr, "checksum: %f\n", sum);
+    }
+  }
+
+  ht_delete_all(&table);
+  free(lengths);
+  free(starts);
+  free(buffer);
+  free(keys);
+}
+
+/// @brief Sums values of merged tables
+/// @param dst value in the table merged into
+/// @param src value in the merged table
+/// @return sum of the values
+static float bench_sum(float dst, float src) { return dst + src; }
+
+/// @brief Measures building of the table from all items at once and merging
+///        of per thread tables
+/// @param csv file for machine readable results
+static void bench_build(FILE *csv) {
+  char(*keys)[BENCH_KEY] = malloc(BENCH_MAX_ITEMS * sizeof(*keys));
+  ht_pair_t *items = malloc(BENCH_MAX_ITEMS * sizeof(ht_pair_t));
+  bench_generate(BENCH_UNIFORM, keys);
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    items[i].key = keys[i];
+    items[i].value = i;
+  }
+
+  printf("\n%-12s %12s %12s\n", "build", "ns/item", "speedup");
+  double start = bench_now();
+  ht_table_t table;
+  ht_init(&table);
+  for (int i = 0; i < BENCH_MAX_ITEMS; i++) {
+    ht_insert(&table, keys[i], i);
+  }
+  double single = (bench_now() - start) / BENCH_MAX_ITEMS;
+  printf("%-12s %12.2f %12.2f\n", "ht_insert", single, 1.0);
+  fprintf(csv, "%s,build,%d,ht_insert,%.2f,,,,,\n", BENCH_BACKEND,
+          BENCH_MAX_ITEMS, single);
+
+  for (int threads = 1; threads <= BENCH_THREADS; threads *= 2) {
+    ht_shared_t shared;
+    start = bench_now();
+    ht_build_parallel(&shared, items, BENCH_MAX_ITEMS, threads);
+    double per_item = (bench_now() - start) / BENCH_MAX_ITEMS;
+    printf("threads_%-4d %12.2f %12.2f\n", threads, per_item,
+           single / per_item);
+    fprintf(csv, "%s,build,%d,threads_%d,%.2f,,,,,\n", BENCH_BACKEND,
+            BENCH_MAX_ITEMS, threads, per_item);
+    ht_shared_delete_all(&shared);
+  }
+
+  // Each of the tables counts a quarter of the keys and a common half
+  ht_table_t parts[4];
+  for (int t = 0; t < 4; t++) {
+    ht_init(&parts[t]);
+    for (int i = 0; i < BENCH_MAX_ITEMS / 4; i++) {
+      ht_insert(&parts[t], keys[i % 2 ? i : t * (BENCH_MAX_ITEMS / 4) + i],
+                1);
+    }
+  }
+  ht_table_t merged;
+  ht_init(&merged);
+  start = bench_now();
+  for (int t = 0; t < 4; t++) {
+    ht_merge(&merged, &parts[t], bench_sum);
+  }
+  double per_item = (bench_now() - start) / BENCH_MAX_ITEMS;
+  printf("%-12s %12.2f\n", "ht_merge", per_item);
+  fprintf(csv, "%s,build,%d,ht_merge,%.2f,,,,,\n", BENCH_BACKEND,
+          BENCH_MAX_ITEMS, per_item);
+
+  ht_delete_all(&merged);
+  for (int t = 0; t < 4; t++) {
+    ht_delete_all(&parts[t]);
+  }
+  ht_delete_all(&table);
+  free(items);
+  free(keys);
+}
+
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : "bench.csv";
+  FILE *csv = fopen(path, "w");
+  if (!csv) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return 1;
+  }
+  fprintf(csv, "backend,keys,items,op,ns_per_op,p50_ns,p99_ns,"
+               "allocs_per_op,misses_per_op,misses_source\n");
+
+  bench_calibrate();
+  bench_perf_open();
+  if (bench_perf >= 0) {
+    ioctl(bench_perf, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  bench_suite(csv);
+  bench_batch(csv);
+  bench_filter(csv);
+  bench_accumulate(csv);
+  bench_typed(csv);
+  bench_aggregate(csv);
+  bench_shared(csv);
+  bench_build(csv);
+  bench_frozen(csv);
+  bench_slices(csv);
+
+  fclose(csv);
+  printf("\nResults written to %s\n", path);
+}
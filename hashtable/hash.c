@@ -0,0 +1,135 @@
+/*
+ * Rozptylovací funkce sdílená všemi implementacemi tabulky.
+ */
+
+#include "hashtable.h"
+#include <stddef.h>
+
+uint64_t HT_SEED = 0x2d358dccaa6c78a5ull;
+
+// Odd constants with balanced bits, used to spread input of ht_mix
+#define HT_P0 0xa0761d6478bd642full
+#define HT_P1 0xe7037ed1a0b428dbull
+#define HT_P2 0x8ebc6af09c88c6e3ull
+#define HT_P3 0x589965cc75374cc3ull
+
+// Bits set in every byte, used for finding zero byte in a word
+#define HT_ONES 0x0101010101010101ull
+#define HT_HIGHS 0x8080808080808080ull
+
+/// @brief Multiplies two words and folds the 128 bit result into one word
+/// @param a first word
+/// @param b second word
+/// @return xor of the lower and the upper half of the product
+static inline uint64_t ht_mix(uint64_t a, uint64_t b) {
+    __extension__ unsigned __int128 product = (unsigned __int128)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+// Word which may be read from unaligned address
+typedef uint64_t __attribute__((may_alias, aligned(1))) ht_word_t;
+
+/// @brief Reads 8 bytes from memory as a little endian word
+/// @param p pointer to the bytes, doesn't have to be aligned
+/// @return read word
+__attribute__((no_sanitize_address))
+static inline uint64_t ht_read64(const char *p) {
+    uint64_t word = *(const ht_word_t *)p;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+/// @brief Mixes last word and length of the key into the state
+/// @param state state after all full words of the key
+/// @param last remaining bytes of the key, zero padded
+/// @param length length of the key
+/// @return hash of the key
+static inline uint64_t ht_finish(uint64_t state, uint64_t last,
+                                 size_t length) {
+    // Length is mixed in at the end, so the key is read just once
+    return ht_mix(ht_mix(last ^ HT_P1, state ^ HT_P3) ^ length, HT_P0);
+}
+
+/// @brief Hashes key and gets its length in a single pass
+///
+/// Key is read 8 bytes at a time. Word may be read past the terminating
+/// zero, but never across a page boundary, so it can't fault. That's also
+/// why address sanitizer is disabled for this function.
+///
+/// @param key zero terminated key to be hashed
+/// @param length set to length of the key, may be NULL
+/// @return hash of the key
+__attribute__((no_sanitize_address))
+uint64_t ht_hash(const char *key, size_t *length) {
+    uint64_t state = HT_SEED ^ HT_P0;
+    const char *p = key;
+    uint64_t last;
+    for (;;) {
+        uint64_t word;
+        // Reads the word at once when it's on a single page
+        if (((uintptr_t)p & 4095) <= 4096 - sizeof(word)) {
+            word = ht_read64(p);
+        } else {
+            word = 0;
+            // Bytes after the terminating zero stay zero
+            for (int i = 0; i < 8 && p[i]; ++i)
+                word |= (uint64_t)(unsigned char)p[i] << (i * 8);
+        }
+
+        // Word contains terminating zero, rest of the key is the last word
+        uint64_t zero = (word - HT_ONES) & ~word & HT_HIGHS;
+        if (zero) {
+            int bytes = __builtin_ctzll(zero) / 8;
+            last = bytes ? word & (~0ull >> (64 - bytes * 8)) : 0;
+            p += bytes;
+            break;
+        }
+        state = ht_mix(word ^ HT_P1, state ^ HT_P2);
+        p += sizeof(word);
+    }
+
+    size_t len = p - key;
+    if (length)
+        *length = len;
+    return ht_finish(state, last, len);
+}
+
+/// @brief Hashes key of known length, which doesn't have to be terminated
+///
+/// Gives the same hash as ht_hash for the same bytes. Last word is read at
+/// once only when it's on a single page, like in ht_hash, bytes past the
+/// key are masked out.
+///
+/// @param key key to be hashed, may contain zero bytes
+/// @param length length of the key
+/// @return hash of the key
+__attribute__((no_sanitize_address))
+uint64_t ht_hash_n(const char *key, size_t length) {
+    uint64_t state = HT_SEED ^ HT_P0;
+    const char *p = key;
+    const char *end = key + length;
+    for (; end - p >= 8; p += 8)
+        state = ht_mix(ht_read64(p) ^ HT_P1, state ^ HT_P2);
+
+    uint64_t last = 0;
+    int bytes = end - p;
+    if (bytes && ((uintptr_t)p & 4095) <= 4096 - sizeof(last)) {
+        last = ht_read64(p) & (~0ull >> (64 - bytes * 8));
+    } else {
+        for (int i = 0; i < bytes; ++i)
+            last |= (uint64_t)(unsigned char)p[i] << (i * 8);
+    }
+    return ht_finish(state, last, length);
+}
+
+/*
+ * Rozptylovací funkce která přidělí zadanému klíči hash kód. Index do tabulky
+ * se z něj získá podle aktuální velikosti tabulky. Ideální rozptylovací
+ * funkce by měla rozprostírat klíče rovnoměrně po všech indexech. Zamyslete
+ * sa nad kvalitou zvolené funkce.
+ */
+uint64_t get_hash(char *key) {
+  return ht_hash(key, NULL);
+}
@@ -9,32 +9,505 @@
  */
 
 #include "hashtable.h"
+#include "hashtable_filter.h"
+#include "hashtable_merge.h"
+#include "hashtable_snapshot.h"
+#include "hashtable_values.h"
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 int HT_SIZE = MAX_HT_SIZE;
 
-/*
- * Rozptylovací funkce která přidělí zadanému klíči index z intervalu
- * <0,HT_SIZE-1>. Ideální rozptylovací funkce by měla rozprostírat klíče
- * rovnoměrně po všech indexech. Zamyslete sa nad kvalitou zvolené funkce.
- */
-int get_hash(char *key) {
-  int result = 1;
-  int length = strlen(key);
-  for (int i = 0; i < length; i++) {
-    result += key[i];
-  }
-  return (result % HT_SIZE);
+// Length of key of freed item, so iterators going through slabs skip it,
+// no key of the table is that long
+#define HT_FREED HT_MAX_KEY
+
+// Sizes the table grows through, each roughly double the previous one
+static const int HT_PRIMES[] = {
+    53,       97,       193,      389,       769,       1543,     3079,
+    6151,     12289,    24593,    49157,     98317,     196613,   393241,
+    786433,   1572869,  3145739,  6291469,   12582917,  25165843, 50331653,
+    100663319, 201326611, 402653189, 805306457, 1610612741,
+};
+
+/// @brief Gets the first size from HT_PRIMES greater than given size
+/// @param size current size of the table
+/// @return new size, given size when there's no greater one
+static int ht_next_size(int size) {
+    int count = sizeof(HT_PRIMES) / sizeof(HT_PRIMES[0]);
+    for (int i = 0; i < count; ++i) {
+        if (HT_PRIMES[i] > size)
+            return HT_PRIMES[i];
+    }
+    return size;
+}
+
+/// @brief Gets list in which item with given hash is or should be stored
+/// @param table table to get the list from, must have lists allocated
+/// @param hash hash of the item key
+/// @return pointer to the first item of the list
+static ht_item_t **ht_list(ht_table_t *table, uint64_t hash) {
+    // Not yet moved list from the old array contains all its keys, keys
+    // are inserted to the new array only after their old list was moved
+    if (table->old_items) {
+        ht_item_t **old = &table->old_items[hash % table->old_size];
+        if (*old)
+            return old;
+    }
+    return &table->items[hash % table->size];
+}
+
+/// @brief Moves list from the old array to the new array
+/// @param table table which is being rehashed
+/// @param index index of the list in the old array
+static void ht_rehash_list(ht_table_t *table, int index) {
+    ht_item_t *temp = table->old_items[index];
+    while (temp) {
+        ht_item_t *next = temp->next;
+        // Prepends item to the list in the new array
+        ht_item_t **list = &table->items[temp->hash % table->size];
+        temp->next = *list;
+        *list = temp;
+        temp = next;
+    }
+    table->old_items[index] = NULL;
+}
+
+/// @brief Moves a few lists from the old array, frees it when it's empty
+/// @param table table which may be rehashed
+static void ht_rehash_step(ht_table_t *table) {
+    if (!table->old_items)
+        return;
+
+    // Moves at most HT_REHASH_STEP lists, skips limited count of empty ones
+    int moved = 0;
+    int empty = HT_REHASH_STEP * 10;
+    while (moved < HT_REHASH_STEP && table->rehash_index < table->old_size) {
+        if (table->old_items[table->rehash_index]) {
+            ht_rehash_list(table, table->rehash_index);
+            ++moved;
+        } else if (--empty == 0) {
+            break;
+        }
+        ++table->rehash_index;
+    }
+
+    // All the lists were moved, old array isn't needed anymore
+    if (table->rehash_index == table->old_size) {
+        free(table->old_items);
+        table->old_items = NULL;
+        table->old_size = 0;
+        table->rehash_index = 0;
+    }
+}
+
+/// @brief Starts rehashing to greater array when load factor is exceeded
+/// @param table table to be checked
+static void ht_grow(ht_table_t *table) {
+    if (table->old_items || table->count < table->size * HT_MAX_LOAD)
+        return;
+
+    int size = ht_next_size(table->size);
+    if (size == table->size)
+        return;
+    ht_item_t **items = calloc(size, sizeof(ht_item_t *));
+    if (!items)
+        return;
+
+    // Current array becomes old one, its lists are moved incrementally
+    table->old_items = table->items;
+    table->old_size = table->size;
+    table->rehash_index = 0;
+    table->items = items;
+    table->size = size;
+}
+
+/// @brief Allocates item from slabs of the table
+/// @param table table to allocate the item for
+/// @return allocated item, NULL when allocation failed
+static ht_item_t *ht_alloc_item(ht_table_t *table) {
+    // Reuses deleted item when there is any
+    ht_item_t *item = table->free_items;
+    if (item) {
+        table->free_items = item->next;
+        return item;
+    }
+
+    // Allocates new slab when the newest one is full
+    ht_slab_t *slab = table->slabs;
+    if (!slab || table->slab_used == slab->capacity) {
+        int capacity = slab ? slab->capacity * 2 : HT_SLAB_MIN;
+        if (capacity > HT_SLAB_MAX)
+            capacity = HT_SLAB_MAX;
+        // Items are aligned to cache lines, so each is read at once
+        size_t size = sizeof(ht_slab_t) + capacity * HT_ITEM_SIZE;
+#ifdef HT_COLUMNAR
+        size += capacity * sizeof(float);
+#endif
+        slab = aligned_alloc(HT_ITEM_SIZE, size);
+        if (!slab)
+            return NULL;
+        slab->next = table->slabs;
+        slab->capacity = capacity;
+#ifdef HT_COLUMNAR
+        // Column of values follows the items, unused values are NaN so
+        // the column is aggregated without checking which items are used
+        slab->values = (float *)(slab->items + capacity * HT_ITEM_SIZE);
+        for (int i = 0; i < capacity; ++i)
+            slab->values[i] = NAN;
+#endif
+        table->slabs = slab;
+        table->slab_used = 0;
+    }
+    item = (ht_item_t *)(slab->items + table->slab_used * HT_ITEM_SIZE);
+#ifdef HT_COLUMNAR
+    // Item keeps its value slot, also when it's reused
+    item->value = &slab->values[table->slab_used];
+#endif
+    ++table->slab_used;
+    return item;
+}
+
+/// @brief Returns item to the table so it can be reused by next insert
+/// @param table table the item was allocated from
+/// @param item item to be freed
+static void ht_free_item(ht_table_t *table, ht_item_t *item) {
+    // Key stored outside of the item is owned by it
+    if (item->length >= HT_INLINE_KEY) {
+        free(ht_item_key(item));
+        --table->long_keys;
+    }
+#ifdef HT_COLUMNAR
+    *item->value = NAN;
+#endif
+    item->length = HT_FREED;
+    item->next = table->free_items;
+    table->free_items = item;
+}
+
+/// @brief Gets key of the item
+/// @param item item to get the key of
+/// @return zero terminated key owned by the item
+char *ht_item_key(ht_item_t *item) {
+    if (item->length < HT_INLINE_KEY)
+        return item->key;
+    // Long key is stored separately, the item contains pointer to it
+    char *key;
+    memcpy(&key, item->key, sizeof(key));
+    return key;
+}
+
+/// @brief Copies key into the item
+/// @param table table the item belongs to
+/// @param item item to store the key in, its length must be set
+/// @param key key to be copied
+/// @return true on success, false when allocation failed
+static bool ht_set_key(ht_table_t *table, ht_item_t *item, const char *key) {
+    // Short keys are stored inside the item
+    if (item->length < HT_INLINE_KEY) {
+        memcpy(item->key, key, item->length);
+        item->key[item->length] = 0;
+        return true;
+    }
+
+    char *copy = malloc(item->length + 1);
+    if (!copy)
+        return false;
+    memcpy(copy, key, item->length);
+    copy[item->length] = 0;
+    memcpy(item->key, &copy, sizeof(copy));
+    ++table->long_keys;
+    return true;
+}
+
+/// @brief Gets number of bytes used by item with key of given length
+/// @param length length of the key
+/// @return size of the item and of its key when it's stored separately
+static size_t ht_item_bytes(size_t length) {
+    return HT_ITEM_SIZE + (length >= HT_INLINE_KEY ? length + 1 : 0);
+}
+
+/// @brief Adds hashes of all items of given array of lists to the filter
+/// @param filter filter to add to
+/// @param items array of lists, may be NULL
+/// @param size number of lists in the array
+static void ht_filter_lists(ht_filter_t *filter, ht_item_t **items, int size) {
+    for (int i = 0; items && i < size; ++i) {
+        for (ht_item_t *temp = items[i]; temp; temp = temp->next)
+            ht_filter_add(filter, temp->hash);
+    }
+}
+
+/// @brief Adds all keys of the table to the filter
+/// @param table table whose keys are added
+/// @param filter filter to add to
+static void ht_filter_table(ht_table_t *table, ht_filter_t *filter) {
+    ht_filter_lists(filter, table->items, table->size);
+    ht_filter_lists(filter, table->old_items, table->old_size);
+    if (table->snapshot)
+        ht_filter_add_snapshot(filter, table->snapshot);
+}
+
+/// @brief Gets number of keys of the table including the mapped ones
+/// @param table table to count
+/// @return number of the keys
+static int ht_keys(ht_table_t *table) {
+    return table->count + (table->snapshot ? table->snapshot->count : 0);
+}
+
+/// @brief Builds the filter again when it's too full or has too many keys
+///        which were deleted
+/// @param table table whose filter is checked
+static void ht_filter_refresh(ht_table_t *table) {
+    if (!table->filter || !ht_filter_stale(table->filter, ht_keys(table)))
+        return;
+    // Stale filter is still correct, so it's kept when allocation fails
+    ht_filter_t *filter = ht_filter_resize(table->filter, ht_keys(table));
+    if (!filter)
+        return;
+    ht_filter_table(table, filter);
+    table->filter = filter;
+}
+
+/// @brief Removes item from its list and frees it
+/// @param table table the item belongs to
+/// @param link pointer to the item in its list
+static void ht_remove(ht_table_t *table, ht_item_t **link) {
+    // Links next item to the previous one (or to the list start)
+    ht_item_t *rem = *link;
+    *link = rem->next;
+    table->cache.bytes -= ht_item_bytes(rem->length);
+    // Frees item to be deleted, so it can be reused
+    ht_free_item(table, rem);
+    --table->count;
+    ht_filter_remove(table->filter);
+    ht_filter_refresh(table);
+}
+
+/// @brief Evicts one item which wasn't found since the last eviction pass
+///
+/// Uses CLOCK policy. The hand goes through the lists, clears reference bits
+/// of found items and evicts the first item whose bit is already clear.
+/// While rehashing, the hand goes through lists of the old array first and
+/// then through the new array, so the rehash isn't finished at once.
+///
+/// @param table table to evict from, must contain an item
+static void ht_evict(ht_table_t *table) {
+    int lists = table->old_size + table->size;
+    for (;; table->cache.hand = (table->cache.hand + 1) % lists) {
+        int hand = table->cache.hand % lists;
+        ht_item_t **temp = hand < table->old_size
+                               ? &table->old_items[hand]
+                               : &table->items[hand - table->old_size];
+        for (; *temp; temp = &(*temp)->next) {
+            if ((*temp)->referenced) {
+                (*temp)->referenced = 0;
+                continue;
+            }
+            ht_remove(table, temp);
+            ++table->cache.evictions;
+            return;
+        }
+    }
+}
+
+/// @brief Checks whether the table is over its budget
+/// @param table table to check
+/// @param items number of items to be added
+/// @param bytes number of bytes to be added
+/// @return true when an item has to be evicted, else false
+static bool ht_over_budget(ht_table_t *table, int items, size_t bytes) {
+    ht_cache_t *cache = &table->cache;
+    return table->count > 0 &&
+           ((cache->max_items && table->count + items > cache->max_items) ||
+            (cache->max_bytes && cache->bytes + bytes > cache->max_bytes));
+}
+
+/// @brief Checks if item has given key
+/// @param item item to be checked
+/// @param key key to compare with
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return true when the keys are equal, else false
+static inline bool ht_item_equals(ht_item_t *item, const char *key,
+                                  size_t length, uint64_t hash) {
+    // Hashes and lengths are compared first, so most of the synonyms are
+    // skipped without comparing keys
+    return item->hash == hash && item->length == length &&
+           memcmp(ht_item_key(item), key, length) == 0;
 }
 
 /*
  * Inicializace tabulky — zavolá sa před prvním použitím tabulky.
  */
 void ht_init(ht_table_t *table) {
-    for (int i = 0; i < MAX_HT_SIZE; ++i) {
-        (*table)[i] = NULL;
+    // Lists are allocated on the first insert
+    table->items = NULL;
+    table->size = 0;
+    table->old_items = NULL;
+    table->old_size = 0;
+    table->rehash_index = 0;
+    table->count = 0;
+    // Slabs are allocated on demand too
+    table->slabs = NULL;
+    table->slab_used = 0;
+    table->free_items = NULL;
+    table->long_keys = 0;
+    table->snapshot = NULL;
+    memset(&table->cache, 0, sizeof(table->cache));
+    table->filter = NULL;
+#ifdef HT_COUNTERS
+    memset(&table->counters, 0, sizeof(table->counters));
+#endif
+}
+
+/// @brief Adds new item to the table
+/// @param table table to add to
+/// @param key key of the item, it's copied
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param value value of the item
+/// @return added item, NULL when allocation failed
+static ht_item_t *ht_add(ht_table_t *table, const char *key, size_t length,
+                         uint64_t hash, float value) {
+    // Allocates lists on the first insert
+    if (!table->items) {
+        table->items = calloc(HT_SIZE, sizeof(ht_item_t *));
+        if (!table->items)
+            return NULL;
+        table->size = HT_SIZE;
     }
+    // Cache makes room for the new item instead of growing
+    while (ht_over_budget(table, 1, ht_item_bytes(length)))
+        ht_evict(table);
+    ht_rehash_step(table);
+    ht_grow(table);
+
+    // Moves old list of the key first, so the new item isn't split from its
+    // synonyms
+    if (table->old_items)
+        ht_rehash_list(table, hash % table->old_size);
+
+    // Creates new item, the key is copied into it
+    ht_item_t *temp = ht_alloc_item(table);
+    if (!temp)
+        return NULL;
+    temp->length = length;
+    if (!ht_set_key(table, temp, key)) {
+        temp->length = 0;
+        ht_free_item(table, temp);
+        return NULL;
+    }
+    HT_VALUE(temp) = value;
+    temp->hash = hash;
+    temp->referenced = 0;
+    table->cache.bytes += ht_item_bytes(length);
+    // Sets next item to the item that was previously first in the linked list
+    // on given index
+    ht_item_t **list = &table->items[hash % table->size];
+    temp->next = *list;
+
+    // Adds created item to the linked list
+    *list = temp;
+    ++table->count;
+    if (table->filter) {
+        ht_filter_add(table->filter, hash);
+        ht_filter_refresh(table);
+    }
+    return temp;
+}
+
+/// @brief Searches for item whose key passed the filter in the lists only
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return found item, NULL when not found
+static ht_item_t *ht_lookup_lists(ht_table_t *table, const char *key,
+                                  size_t length, uint64_t hash) {
+    HT_COUNT(table, searches, 1);
+    // Empty table doesn't have any lists allocated
+    if (!table->items)
+        return NULL;
+    // Iterates linked list of the key until it finds key
+    for (ht_item_t *temp = *ht_list(table, hash); temp; temp = temp->next) {
+        HT_COUNT(table, probes, 1);
+        if (ht_item_equals(temp, key, length, hash)) {
+            HT_COUNT(table, hits, 1);
+            // Line of the item is written only when the bit changes
+            if (!temp->referenced)
+                temp->referenced = 1;
+            return temp;
+        }
+    }
+    return NULL;
+}
+
+/// @brief Counts search of key which isn't in the table
+/// @param table table which was searched
+static void ht_missed(ht_table_t *table) {
+    HT_COUNT(table, misses, 1);
+    ht_filter_missed(table->filter);
+}
+
+/// @brief Searches for item whose key passed the filter, moves item of
+///        mapped snapshot to the table
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return found item, NULL when not found or when the mapped item couldn't
+///         be moved
+static ht_item_t *ht_lookup(ht_table_t *table, const char *key, size_t length,
+                            uint64_t hash) {
+    ht_item_t *found = ht_lookup_lists(table, key, length, hash);
+    if (found)
+        return found;
+
+    // Item of mapped snapshot moves to the table, so the returned item can
+    // be changed and kept like any other. The record is removed only after
+    // the item was added, so failed allocation doesn't lose it.
+    ht_snapshot_record_t *record =
+        table->snapshot ? ht_snapshot_search(table->snapshot, key, length, hash)
+                        : NULL;
+    if (record) {
+        ht_item_t *moved = ht_add(table, key, length, hash, record->value);
+        if (moved) {
+            ht_snapshot_remove(table->snapshot, record);
+            HT_COUNT(table, hits, 1);
+            return moved;
+        }
+    }
+
+    // Item wasn't found
+    ht_missed(table);
+    return NULL;
+}
+
+/// @brief Checks the key by the filter of the table
+/// @param table table whose filter is used
+/// @param hash hash of the key
+/// @return true when the key surely isn't in the table, else false
+static bool ht_rejected(ht_table_t *table, uint64_t hash) {
+    if (ht_filter_pass(table->filter, hash))
+        return false;
+    HT_COUNT(table, searches, 1);
+    HT_COUNT(table, misses, 1);
+    return true;
+}
+
+/// @brief Searches for item with given key and its already computed hash
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return found item, NULL when not found
+ht_item_t *ht_search_hashed(ht_table_t *table, const char *key, size_t length,
+                            uint64_t hash) {
+    if (length >= HT_MAX_KEY || ht_rejected(table, hash))
+        return NULL;
+    return ht_lookup(table, key, length, hash);
 }
 
 /*
@@ -44,17 +517,24 @@ void ht_init(ht_table_t *table) {
  * hodnotu NULL.
  */
 ht_item_t *ht_search(ht_table_t *table, char *key) {
-    // Gets hash from the hash function based on key
-    int hash = get_hash(key);
-
-    // Iterates linked list on hash index until it finds key
-    for (ht_item_t *temp = (*table)[hash]; temp; temp = temp->next) {
-        if (temp->key == key)
-            return temp;
-    }
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    return ht_search_hashed(table, key, length, hash);
+}
 
-    // Item wasn't found
-    return NULL;
+/// @brief Searches for item with key of given length
+///
+/// The key is hashed and compared in place, it isn't copied, so it can be
+/// a slice of a bigger buffer.
+///
+/// @param table table to search in
+/// @param key key of the item, doesn't have to be zero terminated
+/// @param length length of the key
+/// @return found item, NULL when not found
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length) {
+    if (length >= HT_MAX_KEY)
+        return NULL;
+    return ht_search_hashed(table, key, length, ht_hash_n(key, length));
 }
 
 /*
@@ -66,24 +546,97 @@ ht_item_t *ht_search(ht_table_t *table, char *key) {
  * synonym zvolte nejefektivnější možnost a vložte prvek na začátek seznamu.
  */
 void ht_insert(ht_table_t *table, char *key, float value) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_insert_hashed(table, key, length, hash, value);
+}
+
+/// @brief Inserts item with key of given length
+/// @param table table to insert to
+/// @param key key of the item, doesn't have to be zero terminated, the copy
+///        owned by the table is
+/// @param length length of the key
+/// @param value value of the item, replaces value of existing item
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value) {
+    if (length >= HT_MAX_KEY)
+        return;
+    ht_insert_hashed(table, key, length, ht_hash_n(key, length), value);
+}
+
+/// @brief Inserts item with given key and its already computed hash
+/// @param table table to insert to
+/// @param key key of the item, it's copied
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param value value of the item, replaces value of existing item
+void ht_insert_hashed(ht_table_t *table, const char *key, size_t length,
+                      uint64_t hash, float value) {
+    if (length >= HT_MAX_KEY)
+        return;
     // Searches for key in table, changes the value to new value if exists
-    ht_item_t *temp = ht_search(table, key);
+    ht_item_t *temp = ht_search_hashed(table, key, length, hash);
     if (temp) {
-        temp->value = value;
+        HT_VALUE(temp) = value;
         return;
     }
 
-    // Creates new item
-    int hash = get_hash(key);
-    temp = malloc(sizeof(ht_item_t));
-    temp->key = key;
-    temp->value = value;
-    // Sets next item to the item that was previously first in the linked list
-    // on given index
-    temp->next = (*table)[hash];
+    ht_add(table, key, length, hash, value);
+}
 
-    // Adds created item to the linked list
-    (*table)[hash] = temp;
+/// @brief Gets value of the key, inserts the key with value 0 when it's
+///        missing
+///
+/// The key is hashed once and its list (or probe sequence) is walked once,
+/// unlike ht_get followed by ht_insert.
+///
+/// @param table table to search in
+/// @param key key of the item, it's copied when inserted
+/// @param inserted set to whether the key was inserted, may be NULL
+/// @return pointer to value of the item, valid until the table is changed,
+///         NULL when allocation failed
+float *ht_find_or_insert(ht_table_t *table, char *key, bool *inserted) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    return ht_find_or_insert_hashed(table, key, length, hash, inserted);
+}
+
+/// @brief Gets value of the key and its already computed hash, inserts the
+///        key with value 0 when it's missing
+/// @param table table to search in
+/// @param key key of the item, it's copied when inserted
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param inserted set to whether the key was inserted, may be NULL
+/// @return pointer to value of the item, NULL when allocation failed or the
+///         key is too long
+float *ht_find_or_insert_hashed(ht_table_t *table, const char *key,
+                                size_t length, uint64_t hash, bool *inserted) {
+    if (length >= HT_MAX_KEY) {
+        if (inserted)
+            *inserted = false;
+        return NULL;
+    }
+    ht_item_t *found = ht_search_hashed(table, key, length, hash);
+    bool added = false;
+    if (!found) {
+        found = ht_add(table, key, length, hash, 0);
+        added = found != NULL;
+    }
+    if (inserted)
+        *inserted = added;
+    return found ? &HT_VALUE(found) : NULL;
+}
+
+/// @brief Adds to the value of the key, like ht_get followed by ht_insert
+///        but with one hash and one search
+/// @param table table containing the item
+/// @param key key of the item, inserted with value 0 when it doesn't exist
+/// @param delta number added to the value
+/// @return new value of the item, NaN when allocation failed
+float ht_accumulate(ht_table_t *table, char *key, float delta) {
+    float *value = ht_find_or_insert(table, key, NULL);
+    return value ? *value += delta : NAN;
 }
 
 /*
@@ -95,13 +648,154 @@ void ht_insert(ht_table_t *table, char *key, float value) {
  * Při implementaci využijte funkci ht_search.
  */
 float *ht_get(ht_table_t *table, char *key) {
-    // Searches for item with key in table, returns its value if exists
-    ht_item_t *found = ht_search(table, key);
-    if (found)
-        return &found->value;
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    return ht_get_hashed(table, key, length, hash);
+}
+
+/// @brief Gets value of the key and its already computed hash
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return pointer to the value, NULL when not found
+float *ht_get_hashed(ht_table_t *table, const char *key, size_t length,
+                     uint64_t hash) {
+    if (length >= HT_MAX_KEY || ht_rejected(table, hash)) {
+        ++table->cache.misses;
+        return NULL;
+    }
+    // Values of mapped snapshot are used in place, the item isn't moved
+    if (table->snapshot) {
+        ht_snapshot_record_t *record =
+            ht_snapshot_search(table->snapshot, key, length, hash);
+        if (record) {
+            ++table->cache.hits;
+            return &record->value;
+        }
+    }
+
+    // Snapshot was searched already, only the lists are left
+    ht_item_t *found = ht_lookup_lists(table, key, length, hash);
+    if (found) {
+        ++table->cache.hits;
+        return &HT_VALUE(found);
+    }
+    ht_missed(table);
+    ++table->cache.misses;
     return NULL;
 }
 
+/// @brief Gets value of the key of given length
+/// @param table table to search in
+/// @param key key of the item, doesn't have to be zero terminated
+/// @param length length of the key
+/// @return pointer to the value, NULL when not found
+float *ht_get_n(ht_table_t *table, const char *key, size_t length) {
+    if (length >= HT_MAX_KEY)
+        return NULL;
+    return ht_get_hashed(table, key, length, ht_hash_n(key, length));
+}
+
+/// @brief Gets values of many keys at once
+///
+/// Keys are processed in batches of HT_BATCH. All the keys of a batch are
+/// hashed and starts of their lists prefetched first. Then the lists are
+/// walked one item of each list at a time, so waiting for memory overlaps
+/// across the keys. Keys of mapped snapshot are resolved before the lists,
+/// keys rejected by the filter aren't searched at all.
+///
+/// @param table table to search in
+/// @param keys keys to get the values of
+/// @param n number of keys
+/// @param values set to pointer to value of each key, NULL when not found
+void ht_get_many(ht_table_t *table, char *keys[], int n, float *values[]) {
+    for (int i = 0; i < n; ++i)
+        values[i] = NULL;
+    // Empty table doesn't have any lists allocated
+    if (!table->items && !table->snapshot) {
+        HT_COUNT(table, searches, n);
+        HT_COUNT(table, misses, n);
+        return;
+    }
+
+    for (int start = 0; start < n; start += HT_BATCH) {
+        int count = n - start < HT_BATCH ? n - start : HT_BATCH;
+        char **batch = keys + start;
+        float **found = values + start;
+        uint64_t hashes[HT_BATCH];
+        size_t lengths[HT_BATCH];
+        ht_item_t **lists[HT_BATCH];
+        ht_item_t *items[HT_BATCH];
+        bool passed[HT_BATCH];
+
+        // Hashes the keys and prefetches starts of their lists
+        for (int i = 0; i < count; ++i) {
+            hashes[i] = ht_hash(batch[i], &lengths[i]);
+            passed[i] = ht_filter_pass(table->filter, hashes[i]);
+            if (!passed[i])
+                continue;
+            if (table->snapshot)
+                ht_snapshot_prefetch(table->snapshot, hashes[i]);
+            if (!table->items)
+                continue;
+            lists[i] = ht_list(table, hashes[i]);
+            __builtin_prefetch(lists[i]);
+        }
+        // Values of mapped snapshot are used in place
+        for (int i = 0; table->snapshot && i < count; ++i) {
+            if (!passed[i])
+                continue;
+            ht_snapshot_record_t *record = ht_snapshot_search(
+                table->snapshot, batch[i], lengths[i], hashes[i]);
+            if (record)
+                found[i] = &record->value;
+        }
+        // Prefetches first items of the lists
+        for (int i = 0; i < count; ++i) {
+            items[i] =
+                found[i] || !passed[i] || !table->items ? NULL : *lists[i];
+            if (items[i])
+                __builtin_prefetch(items[i]);
+        }
+
+        // Checks one item of each list per round, until all keys are
+        // resolved
+        HT_COUNT(table, searches, count);
+        for (int active = count; active;) {
+            active = 0;
+            for (int i = 0; i < count; ++i) {
+                ht_item_t *item = items[i];
+                if (!item)
+                    continue;
+                HT_COUNT(table, probes, 1);
+                if (ht_item_equals(item, batch[i], lengths[i], hashes[i])) {
+                    HT_COUNT(table, hits, 1);
+                    if (!item->referenced)
+                        item->referenced = 1;
+                    found[i] = &HT_VALUE(item);
+                    items[i] = NULL;
+                    continue;
+                }
+                items[i] = item->next;
+                if (items[i]) {
+                    __builtin_prefetch(items[i]);
+                    ++active;
+                }
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            table->cache.hits += found[i] != NULL;
+            table->cache.misses += !found[i];
+            if (passed[i] && !found[i])
+                ht_filter_missed(table->filter);
+#ifdef HT_COUNTERS
+            table->counters.misses += !found[i];
+#endif
+        }
+    }
+}
+
 /*
  * Smazání prvku z tabulky.
  *
@@ -111,24 +805,70 @@ float *ht_get(ht_table_t *table, char *key) {
  * Při implementaci NEPOUŽÍVEJTE funkci ht_search.
  */
 void ht_delete(ht_table_t *table, char *key) {
-    // Gets hash of the key
-    int hash = get_hash(key);
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_delete_hashed(table, key, length, hash);
+}
+
+/// @brief Deletes item with key of given length
+/// @param table table to delete from
+/// @param key key of the item, doesn't have to be zero terminated
+/// @param length length of the key
+void ht_delete_n(ht_table_t *table, const char *key, size_t length) {
+    if (length >= HT_MAX_KEY)
+        return;
+    ht_delete_hashed(table, key, length, ht_hash_n(key, length));
+}
+
+/// @brief Deletes item with given key and its already computed hash
+/// @param table table to delete from
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+void ht_delete_hashed(ht_table_t *table, const char *key, size_t length,
+                      uint64_t hash) {
+    if (length >= HT_MAX_KEY || !ht_filter_pass(table->filter, hash))
+        return;
+    // Item of mapped snapshot is removed from the mapping only
+    if (table->snapshot &&
+        ht_snapshot_take(table->snapshot, key, length, hash, NULL)) {
+        ht_filter_remove(table->filter);
+        ht_filter_refresh(table);
+        return;
+    }
+    // Empty table doesn't have any lists allocated
+    if (!table->items) {
+        ht_filter_missed(table->filter);
+        return;
+    }
+    ht_rehash_step(table);
 
-    // Iterates linked list on hash index until it finds item with key
-    ht_item_t *prev = NULL;
-    for (ht_item_t *temp = (*table)[hash]; temp; prev = temp, temp = temp->next) {
+    // Iterates linked list of the key until it finds item with key
+    for (ht_item_t **temp = ht_list(table, hash); *temp;
+         temp = &(*temp)->next) {
         // Continues iterating when current item doesn't have given key
-        if (temp->key != key)
+        if (!ht_item_equals(*temp, key, length, hash))
             continue;
 
-        // When previous item exists, links next item to the previous
         // Skips current item, which is item to be deleted
-        if (prev)
-            prev->next = temp->next;
-        // Frees item to be deleted
-        free(temp);
+        ht_remove(table, temp);
         return;
     }
+    ht_filter_missed(table->filter);
+}
+
+/// @brief Frees keys stored outside of items in given array of lists
+/// @param items array of lists, may be NULL
+/// @param size number of lists in the array
+static void ht_free_long_keys(ht_item_t **items, int size) {
+    if (!items)
+        return;
+    for (int i = 0; i < size; ++i) {
+        for (ht_item_t *temp = items[i]; temp; temp = temp->next) {
+            if (temp->length >= HT_INLINE_KEY)
+                free(ht_item_key(temp));
+        }
+    }
 }
 
 /*
@@ -138,15 +878,337 @@ void ht_delete(ht_table_t *table, char *key) {
  * inicializaci.
  */
 void ht_delete_all(ht_table_t *table) {
-    // Iterates all linked lists in the table
-    for (int i = 0; i < MAX_HT_SIZE; ++i) {
-        // Iterates all items in linked list and frees them
-        for (ht_item_t *temp = (*table)[i]; temp;) {
-            ht_item_t *next = temp->next;
-            free(temp);
-            temp = next;
+    // Only keys stored outside of items have to be freed one by one
+    if (table->long_keys) {
+        ht_free_long_keys(table->items, table->size);
+        ht_free_long_keys(table->old_items, table->old_size);
+    }
+
+    // Items are freed with their slabs, so the lists aren't iterated
+    for (ht_slab_t *slab = table->slabs; slab;) {
+        ht_slab_t *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    // Old array exists only while rehashing
+    free(table->items);
+    free(table->old_items);
+    ht_snapshot_unmap(table->snapshot);
+    ht_filter_free(table->filter);
+
+    // Table shrinks back to the state after initialization
+    ht_init(table);
+}
+
+/// @brief Gets memory usage of items of the table
+/// @param table table to get the usage of
+/// @param live set to number of bytes used by items in the table
+/// @param reserved set to number of bytes allocated for items
+void ht_slab_stats(ht_table_t *table, size_t *live, size_t *reserved) {
+    *live = table->count * HT_ITEM_SIZE;
+    *reserved = 0;
+    for (ht_slab_t *slab = table->slabs; slab; slab = slab->next) {
+        *reserved += sizeof(ht_slab_t) + slab->capacity * HT_ITEM_SIZE;
+#ifdef HT_COLUMNAR
+        *reserved += slab->capacity * sizeof(float);
+#endif
+    }
+}
+
+/// @brief Adds lengths of lists in given array to the statistics
+/// @param items array of lists, may be NULL
+/// @param size number of lists in the array
+/// @param stats statistics to add to
+static int ht_stats_lists(ht_item_t **items, int size, ht_stats_t *stats) {
+    if (!items)
+        return 0;
+    stats->memory += size * sizeof(ht_item_t *);
+    int count = 0;
+    for (int i = 0; i < size; ++i) {
+        int length = 0;
+        for (ht_item_t *temp = items[i]; temp; temp = temp->next) {
+            ++length;
+            if (temp->length >= HT_INLINE_KEY)
+                stats->memory += temp->length + 1;
+        }
+        ++stats->histogram[length < HT_HISTOGRAM ? length : HT_HISTOGRAM - 1];
+        if (length > stats->max_length)
+            stats->max_length = length;
+        count += length;
+    }
+    return count;
+}
+
+/// @brief Gets statistics of the table
+/// @param table table to get the statistics of
+/// @param stats set to the statistics
+void ht_stats(ht_table_t *table, ht_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->count = table->count;
+    // Items of mapped snapshot aren't in the lists
+    if (table->snapshot)
+        stats->count += table->snapshot->count;
+    // While rehashing, each array has its own load
+    stats->size = table->size;
+    stats->old_size = table->old_size;
+    int count = ht_stats_lists(table->items, table->size, stats);
+    if (stats->size)
+        stats->load = (float)count / stats->size;
+    int old_count = ht_stats_lists(table->old_items, table->old_size, stats);
+    if (stats->old_size)
+        stats->old_load = (float)old_count / stats->old_size;
+
+    size_t live;
+    size_t reserved;
+    ht_slab_stats(table, &live, &reserved);
+    stats->memory += reserved;
+    stats->cache = table->cache;
+    stats->memory += ht_filter_stats(table->filter, &stats->filter);
+#ifdef HT_COUNTERS
+    stats->counters = table->counters;
+#endif
+}
+
+/// @brief Limits the table to given budget, so it can be used as a cache
+///
+/// When the budget is full, insert of a new key evicts items which weren't
+/// found recently (CLOCK policy). A found item only gets its reference bit
+/// set, nothing is relinked. The budget holds until ht_delete_all.
+///
+/// @param table table to limit, items over the budget are evicted at once
+/// @param max_items max number of items, 0 when not limited
+/// @param max_bytes max bytes of items and their keys, 0 when not limited
+void ht_set_budget(ht_table_t *table, int max_items, size_t max_bytes) {
+    table->cache.max_items = max_items;
+    table->cache.max_bytes = max_bytes;
+    while (ht_over_budget(table, 0, 0))
+        ht_evict(table);
+}
+
+/// @brief Enables filter of keys which aren't in the table
+///
+/// Each search first checks the key in blocked Bloom filter, which fits
+/// one block of bits of the key in a cache line. Most of the keys which
+/// aren't in the table are rejected without walking their lists. The filter
+/// is rebuilt when the table outgrows it or after many deletes, it's
+/// disabled by ht_delete_all.
+///
+/// @param table table to filter, its current keys are added
+/// @param fp_rate wanted false positive rate, 0 disables the filter
+/// @return false when the rate isn't in [0, 1) or allocation failed and the
+///         filter is disabled, else true
+bool ht_set_filter(ht_table_t *table, double fp_rate) {
+    ht_filter_free(table->filter);
+    table->filter = NULL;
+    if (fp_rate == 0)
+        return true;
+    if (!(fp_rate > 0 && fp_rate < 1))
+        return false;
+
+    ht_filter_t *filter = ht_filter_create(fp_rate, ht_keys(table));
+    if (!filter)
+        return false;
+    ht_filter_table(table, filter);
+    table->filter = filter;
+    return true;
+}
+
+/// @brief Merges items of given array of lists into the table
+/// @param dst table to merge into
+/// @param items array of lists, may be NULL
+/// @param size number of lists in the array
+/// @param combine combines value in dst with the merged one, may be NULL
+static void ht_merge_lists(ht_table_t *dst, ht_item_t **items, int size,
+                           float (*combine)(float dst, float src)) {
+    for (int i = 0; items && i < size; ++i) {
+        for (ht_item_t *temp = items[i]; temp; temp = temp->next)
+            ht_merge_value(dst, ht_item_key(temp), temp->length, temp->hash,
+                           HT_VALUE(temp), combine);
+    }
+}
+
+/// @brief Merges items stored in one table into another, items of its
+///        mapped snapshot are merged by ht_merge
+/// @param dst table to merge into
+/// @param src table to merge, it isn't changed, mustn't be dst
+/// @param combine combines value in dst with the value in src, NULL when
+///        the value in src replaces it
+void ht_merge_items(ht_table_t *dst, ht_table_t *src,
+                    float (*combine)(float dst, float src)) {
+    ht_merge_lists(dst, src->items, src->size, combine);
+    ht_merge_lists(dst, src->old_items, src->old_size, combine);
+}
+
+/// @brief Collects items of lists in given array
+/// @param items array of lists, may be NULL
+/// @param size number of lists in the array
+/// @param entries buffer for the collected items
+/// @return number of collected items
+static int ht_entries_lists(ht_item_t **items, int size,
+                         ht_snapshot_entry_t *entries) {
+    int count = 0;
+    for (int i = 0; items && i < size; ++i) {
+        for (ht_item_t *temp = items[i]; temp; temp = temp->next) {
+            entries[count].key = ht_item_key(temp);
+            entries[count].hash = temp->hash;
+            entries[count].length = temp->length;
+            entries[count].value = HT_VALUE(temp);
+            ++count;
         }
-        // Sets current linked list to NULL
-        (*table)[i] = NULL;
     }
+    return count;
+}
+
+/// @brief Collects all items of the table including the mapped ones
+/// @param table table to collect from
+/// @param count set to number of the collected items
+/// @return items whose keys are owned by the table, to be freed by caller,
+///         NULL when allocation failed
+ht_snapshot_entry_t *ht_entries(ht_table_t *table, int *count) {
+    int mapped = table->snapshot ? table->snapshot->count : 0;
+    ht_snapshot_entry_t *entries =
+        malloc((table->count + mapped + 1) * sizeof(ht_snapshot_entry_t));
+    if (!entries)
+        return NULL;
+
+    *count = table->snapshot ? ht_snapshot_entries(table->snapshot, entries)
+                             : 0;
+    *count += ht_entries_lists(table->items, table->size, entries + *count);
+    *count +=
+        ht_entries_lists(table->old_items, table->old_size, entries + *count);
+    return entries;
+}
+
+#ifndef HT_COLUMNAR
+
+/// @brief Calls function with value of each item in given array of lists
+/// @param items array of lists, may be NULL
+/// @param size number of lists in the array
+/// @param fn function to call, NaN values are skipped
+/// @param data passed to the function
+static void ht_values_lists(ht_item_t **items, int size,
+                            void (*fn)(float value, void *data), void *data) {
+    for (int i = 0; items && i < size; ++i) {
+        for (ht_item_t *temp = items[i]; temp; temp = temp->next) {
+            if (!isnan(HT_VALUE(temp)))
+                fn(HT_VALUE(temp), data);
+        }
+    }
+}
+
+#endif // HT_COLUMNAR
+
+/// @brief Calls function with each value of the table
+/// @param table table to go through
+/// @param fn function to call, NaN values are skipped
+/// @param data passed to the function
+void ht_for_each_value(ht_table_t *table, void (*fn)(float value, void *data),
+                       void *data) {
+#ifdef HT_COLUMNAR
+    // Value columns are read sequentially instead of following the lists
+    for (ht_slab_t *slab = table->slabs; slab; slab = slab->next) {
+        for (int i = 0; i < slab->capacity; ++i) {
+            if (!isnan(slab->values[i]))
+                fn(slab->values[i], data);
+        }
+    }
+#else
+    ht_values_lists(table->items, table->size, fn, data);
+    ht_values_lists(table->old_items, table->old_size, fn, data);
+#endif
+    if (table->snapshot)
+        ht_snapshot_for_each_value(table->snapshot, fn, data);
+}
+
+/// @brief Aggregates all values of the table in one pass
+/// @param table table to aggregate
+/// @param aggregate set to sum, min, max and count of the values
+void ht_aggregate(ht_table_t *table, ht_aggregate_t *aggregate) {
+    ht_aggregate_init(aggregate);
+#ifdef HT_COLUMNAR
+    // Whole value columns are aggregated with SIMD, unused values are NaN
+    for (ht_slab_t *slab = table->slabs; slab; slab = slab->next)
+        ht_aggregate_values(aggregate, slab->values, slab->capacity);
+    if (table->snapshot)
+        ht_snapshot_for_each_value(table->snapshot, ht_aggregate_value,
+                                   aggregate);
+#else
+    ht_for_each_value(table, ht_aggregate_value, aggregate);
+#endif
+}
+
+/// @brief Starts iteration over all items of the table
+///
+/// Items are returned in order of their memory, which doesn't change when
+/// the table grows. Items deleted before they're reached aren't returned,
+/// items inserted during the iteration may be returned or not. Item moved
+/// from mapped snapshot by ht_search may be returned twice.
+///
+/// @param table table to iterate, mustn't be cleared by ht_delete_all
+/// @param iter set to position before the first item
+void ht_iter_begin(ht_table_t *table, ht_iter_t *iter) {
+    iter->table = table;
+    iter->record = 0;
+    iter->slab = NULL;
+    iter->index = -1;
+}
+
+/// @brief Gets next item of the iteration
+/// @param iter position of the iteration
+/// @param key set to key of the item, owned by the table
+/// @param value set to pointer to value of the item
+/// @return false when there are no more items, else true
+bool ht_iter_next(ht_iter_t *iter, const char **key, float **value) {
+    ht_table_t *table = iter->table;
+    // Items of mapped snapshot go first, so the moved ones land in slabs
+    // which aren't iterated yet
+    if (table->snapshot &&
+        ht_snapshot_next(table->snapshot, &iter->record, key, value))
+        return true;
+
+    // Slabs are taken after the snapshot, including the ones it moved to
+    if (iter->index < 0) {
+        iter->slab = table->slabs;
+        iter->index = 0;
+    }
+    while (iter->slab) {
+        // Only the newest slab may be partly unused
+        int used = iter->slab == table->slabs ? table->slab_used
+                                               : iter->slab->capacity;
+        while (iter->index < used) {
+            ht_item_t *item = (ht_item_t *)(iter->slab->items +
+                                            iter->index++ * HT_ITEM_SIZE);
+            if (item->length == HT_FREED)
+                continue;
+            *key = ht_item_key(item);
+            *value = &HT_VALUE(item);
+            return true;
+        }
+        iter->slab = iter->slab->next;
+        iter->index = 0;
+    }
+    return false;
+}
+
+/// @brief Copies keys and values of the table into arrays
+/// @param table table to export
+/// @param keys filled with keys owned by the table, valid until the table is
+///        changed, may be NULL
+/// @param values filled with the values, may be NULL
+/// @param n capacity of the arrays
+/// @return number of exported items, at most n
+int ht_export(ht_table_t *table, const char *keys[], float values[], int n) {
+    ht_iter_t iter;
+    ht_iter_begin(table, &iter);
+    const char *key;
+    float *value;
+    int count = 0;
+    while (count < n && ht_iter_next(&iter, &key, &value)) {
+        if (keys)
+            keys[count] = key;
+        if (values)
+            values[count] = *value;
+        ++count;
+    }
+    return count;
 }
@@ -7,36 +7,271 @@
 #define IAL_HASHTABLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /*
- * Maximálna veľkosť poľa pre implementáciu tabuľky.
- * Funkcie pracujúce s tabuľkou uvažujú veľkosť HT_SIZE.
+ * Predvolená počiatočná veľkosť poľa pre implementáciu tabuľky.
+ * Tabuľka sa pri zaplnení zväčšuje, toto nie je horná hranica.
  */
 #define MAX_HT_SIZE 101
 
 /*
- * Veľkosť tabuľky s ktorou pracujú implementované funkcie.
+ * Veľkosť tabuľky s ktorou tabuľka začína po inicializácii.
  * Pre účely testovania je vhodné mať možnosť meniť veľkosť tabuľky.
  * Pre správne fungovanie musí byť veľkosť prvočíslom.
  */
 extern int HT_SIZE;
 
+/*
+ * Seed of the hash function. May be changed only while all the tables are
+ * empty, stored hashes of items would not match otherwise.
+ */
+extern uint64_t HT_SEED;
+
+// Keys of this length or longer don't fit the 31 bit length of an item, they
+// are rejected by all functions taking the length
+#define HT_MAX_KEY ((1u << 31) - 1)
+
+// Number of keys of ht_get_many whose lookups are interleaved
+#define HT_BATCH 16
+
+// Number of buckets of histogram of list lengths, last one counts all longer
+#define HT_HISTOGRAM 8
+
+// Counters of searches, they're counted only when compiled with HT_COUNTERS
+typedef struct ht_counters {
+  uint64_t searches; // number of searches
+  uint64_t probes;   // number of items (or groups of slots) checked
+  uint64_t hits;     // number of searches which found the key
+  uint64_t misses;   // number of searches which didn't find the key
+} ht_counters_t;
+
+#ifdef HT_COUNTERS
+#define HT_COUNT(table, counter, n) ((table)->counters.counter += (n))
+#else
+#define HT_COUNT(table, counter, n) ((void)0)
+#endif
+
+// Budget and counters of a table used as a cache, see ht_set_budget
+typedef struct ht_cache {
+  int max_items;      // max number of items, 0 when not limited
+  size_t max_bytes;   // max bytes of items and their keys, 0 when not limited
+  size_t bytes;       // bytes of items and their keys in the table
+  int hand;           // list (or slot) where eviction continues
+  uint64_t hits;      // number of gets which found the key
+  uint64_t misses;    // number of gets which didn't find the key
+  uint64_t evictions; // number of items evicted to keep the budget
+} ht_cache_t;
+
+// Aggregate of all values of a table, NaN values are skipped
+typedef struct ht_aggregate {
+  double sum; // sum of the values
+  float min;  // least value, +infinity when there's none
+  float max;  // greatest value, -infinity when there's none
+  int count;  // number of aggregated values
+} ht_aggregate_t;
+
+// Statistics of the negative lookup filter, see ht_set_filter
+typedef struct ht_filter_stats {
+  double target;            // wanted false positive rate, 0 when disabled
+  double estimate;          // false positive rate estimated from set bits
+  uint64_t checks;          // number of keys checked by the filter
+  uint64_t rejects;         // number of keys rejected without search
+  uint64_t false_positives; // number of keys passed but not found
+} ht_filter_stats_t;
+
+// Statistics of a table
+typedef struct ht_stats {
+  int count;                   // number of items
+  int size;                    // number of lists (or slots) of current array
+  float load;                  // items per list (or slot) of current array
+  int old_size;                // number of lists of old array, 0 when the
+                               // table isn't being rehashed
+  float old_load;              // items per list of old array
+  int max_length;              // length of the longest list (probe sequence)
+  int histogram[HT_HISTOGRAM]; // number of lists (probe sequences) by length
+  size_t memory;               // bytes allocated by the table
+  ht_counters_t counters;      // zero when not compiled with HT_COUNTERS
+  ht_cache_t cache;            // budget and counters of the cache
+  ht_filter_stats_t filter;    // zero when the filter is disabled
+} ht_stats_t;
+
+#ifdef HT_SWISS
+
+// Number of slots whose control bytes are scanned at once
+#define HT_GROUP 16
+
+// Max length of key stored inside the slot, including terminating zero
+#define HT_INLINE_KEY 16
+
+// Prvok tabuľky, uložený priamo v poli tabuľky
+typedef struct ht_item {
+  char key[HT_INLINE_KEY]; // kľúč prvku, pointer to copy when it's too long
+  float value;             // hodnota prvku
+  uint32_t length : 31;    // length of the key
+  uint32_t referenced : 1; // whether it was found since eviction passed it
+  uint64_t hash;           // full hash of the key, used for rehashing too
+} ht_item_t;
+
+// Tabuľka s otvoreným adresovaním
+typedef struct ht_table {
+  int8_t *ctrl;     // tag of each slot (7 bits of hash), empty or deleted
+  ht_item_t *items; // slots, NULL until first insert
+  int size;         // number of slots, power of two multiple of HT_GROUP
+  int count;        // number of items in the table
+  int deleted;      // number of slots marked as deleted
+  int resizes;      // number of times the items were moved by resize
+  struct ht_snapshot *snapshot; // items of mapped file, NULL when not mapped
+  ht_cache_t cache;             // budget and counters of the cache
+  struct ht_filter *filter;     // filter of missing keys, NULL when disabled
+#ifdef HT_COUNTERS
+  ht_counters_t counters; // counters of searches
+#endif
+} ht_table_t;
+
+// Position of iteration, home groups are visited in reversed bit order, so
+// growing the table doesn't skip any of them
+typedef struct ht_iter {
+  ht_table_t *table; // iterated table
+  uint32_t record;   // next record of mapped snapshot
+  uint32_t home;     // home group whose items are returned
+  int group;         // group of the probe sequence of the home group
+  int step;          // number of groups probed before the group
+  int slot;          // next slot in the group
+  int resizes;       // resizes of the table seen by the iterator
+  bool done;         // whether all home groups were visited
+} ht_iter_t;
+
+#else
+
+// Max average number of items per list, table grows when it's exceeded
+#define HT_MAX_LOAD 1
+
+// Number of lists moved to the new array on each insert/delete when rehashing
+#define HT_REHASH_STEP 4
+
+// Number of items in the first slab, each next slab is twice as big
+#define HT_SLAB_MIN 16
+// Max number of items in one slab
+#define HT_SLAB_MAX 4096
+
+// Size of memory of each item including its key, one cache line
+#define HT_ITEM_SIZE 64
+
 // Prvok tabuľky
 typedef struct ht_item {
-  char *key;            // kľúč prvku
-  float value;          // hodnota prvku
-  struct ht_item *next; // ukazateľ na ďalšie synonymum
+  struct ht_item *next;    // ukazateľ na ďalšie synonymum / voľný prvok
+  uint64_t hash;           // full hash of the key, used for rehashing too
+#ifdef HT_COLUMNAR
+  float *value; // hodnota prvku, stored in value column of its slab
+#else
+  float value;             // hodnota prvku
+#endif
+  uint32_t length : 31;    // length of the key
+  uint32_t referenced : 1; // whether it was found since eviction passed it
+  char key[]; // kľúč prvku, pointer to its copy when it's too long
 } ht_item_t;
 
-// Tabuľka o reálnej veľkosti MAX_HT_SIZE
-typedef ht_item_t *ht_table_t[MAX_HT_SIZE];
+// Max length of key stored inside the item, including terminating zero
+#define HT_INLINE_KEY (HT_ITEM_SIZE - (int)sizeof(ht_item_t))
+
+// Block of memory from which items of one table are allocated
+typedef struct ht_slab {
+  struct ht_slab *next; // previously allocated slab
+  int capacity;         // number of items in the slab
+#ifdef HT_COLUMNAR
+  float *values; // values of the items, NaN in unused slots
+#endif
+  // items of the slab, each HT_ITEM_SIZE bytes
+  _Alignas(HT_ITEM_SIZE) unsigned char items[];
+} ht_slab_t;
 
-int get_hash(char *key);
+// Tabuľka
+typedef struct ht_table {
+  ht_item_t **items;     // lists of synonyms, NULL until first insert
+  int size;              // number of lists in items (prime)
+  ht_item_t **old_items; // lists not yet moved to items while rehashing
+  int old_size;          // number of lists in old_items
+  int rehash_index;      // index of the next list in old_items to be moved
+  int count;             // number of items in the table
+  ht_slab_t *slabs;      // slabs of items, the newest first
+  int slab_used;         // number of items ever used in the newest slab
+  ht_item_t *free_items; // deleted items which can be reused
+  int long_keys;         // number of keys stored outside of their items
+  struct ht_snapshot *snapshot; // items of mapped file, NULL when not mapped
+  ht_cache_t cache;             // budget and counters of the cache
+  struct ht_filter *filter;     // filter of missing keys, NULL when disabled
+#ifdef HT_COUNTERS
+  ht_counters_t counters; // counters of searches
+#endif
+} ht_table_t;
+
+// Position of iteration, items stay in their slabs when the table grows
+typedef struct ht_iter {
+  ht_table_t *table; // iterated table
+  uint32_t record;   // next record of mapped snapshot
+  ht_slab_t *slab;   // slab whose items are returned, NULL at the end
+  int index;         // next item in the slab, -1 before the first slab
+} ht_iter_t;
+
+void ht_slab_stats(ht_table_t *table, size_t *live, size_t *reserved);
+
+#endif // HT_SWISS
+
+// Value of the item, use instead of item->value which may be a pointer
+#if defined(HT_COLUMNAR) && !defined(HT_SWISS)
+#define HT_VALUE(item) (*(item)->value)
+#else
+#define HT_VALUE(item) ((item)->value)
+#endif
+
+uint64_t ht_hash(const char *key, size_t *length);
+uint64_t ht_hash_n(const char *key, size_t length);
+uint64_t get_hash(char *key);
+char *ht_item_key(ht_item_t *item);
 void ht_init(ht_table_t *table);
 ht_item_t *ht_search(ht_table_t *table, char *key);
 void ht_insert(ht_table_t *table, char *key, float data);
 float *ht_get(ht_table_t *table, char *key);
+float *ht_find_or_insert(ht_table_t *table, char *key, bool *inserted);
+float ht_accumulate(ht_table_t *table, char *key, float delta);
+void ht_get_many(ht_table_t *table, char *keys[], int n, float *values[]);
 void ht_delete(ht_table_t *table, char *key);
 void ht_delete_all(ht_table_t *table);
+void ht_stats(ht_table_t *table, ht_stats_t *stats);
+void ht_set_budget(ht_table_t *table, int max_items, size_t max_bytes);
+bool ht_set_filter(ht_table_t *table, double fp_rate);
+void ht_aggregate(ht_table_t *table, ht_aggregate_t *aggregate);
+double ht_sum(ht_table_t *table);
+bool ht_minmax(ht_table_t *table, float *min, float *max);
+void ht_for_each_value(ht_table_t *table, void (*fn)(float value, void *data),
+                       void *data);
+void ht_iter_begin(ht_table_t *table, ht_iter_t *iter);
+bool ht_iter_next(ht_iter_t *iter, const char **key, float **value);
+int ht_export(ht_table_t *table, const char *keys[], float values[], int n);
+void ht_merge(ht_table_t *dst, ht_table_t *src,
+              float (*combine)(float dst, float src));
+bool ht_save(ht_table_t *table, const char *path);
+bool ht_open_mapped(ht_table_t *table, const char *path);
+
+// Variants for keys of given length, which don't have to be zero terminated
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length);
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value);
+float *ht_get_n(ht_table_t *table, const char *key, size_t length);
+void ht_delete_n(ht_table_t *table, const char *key, size_t length);
+
+// Variants for callers which already hashed the key using ht_hash
+ht_item_t *ht_search_hashed(ht_table_t *table, const char *key, size_t length,
+                            uint64_t hash);
+void ht_insert_hashed(ht_table_t *table, const char *key, size_t length,
+                      uint64_t hash, float value);
+float *ht_get_hashed(ht_table_t *table, const char *key, size_t length,
+                     uint64_t hash);
+float *ht_find_or_insert_hashed(ht_table_t *table, const char *key,
+                                size_t length, uint64_t hash, bool *inserted);
+void ht_delete_hashed(ht_table_t *table, const char *key, size_t length,
+                      uint64_t hash);
 
 #endif
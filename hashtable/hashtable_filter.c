@@ -0,0 +1,128 @@
+/*
+ * Filtr chybějících klíčů tabulky s rozptýlenými položkami
+ *
+ * Blokový Bloomův filtr: všechny bity jednoho klíče leží v jednom bloku
+ * velikosti řádku cache, takže kontrola klíče čte jediný řádek. Klíče, které
+ * filtr odmítne, v tabulce určitě nejsou a nehledají se. Bity smazaných
+ * klíčů zůstávají nastavené, filtr se proto po mnoha smazáních (nebo když
+ * tabulka přeroste jeho kapacitu) sestaví znovu.
+ */
+
+#include "hashtable_filter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Number of bits of one block
+#define HT_FILTER_BLOCK (HT_FILTER_WORDS * 64)
+// Max number of bits set for each key
+#define HT_FILTER_MAX_BITS 16
+// Natural logarithm of 2, M_LN2 isn't part of C11
+#define HT_LN2 0.69314718055994530942
+
+/// @brief Creates empty filter
+/// @param target wanted false positive rate, greater than 0 and less than 1
+/// @param count number of keys to be added, the filter is sized for twice
+///        as many, so it isn't rebuilt on each next insert
+/// @return created filter, NULL when allocation failed
+ht_filter_t *ht_filter_create(double target, int count) {
+    ht_filter_t *filter = malloc(sizeof(ht_filter_t));
+    if (!filter)
+        return NULL;
+
+    // Optimal Bloom filter has -ln(p) / ln(2)^2 bits per key, ln(2) times as
+    // many of them are set for each key
+    double per_key = -log(target) / (HT_LN2 * HT_LN2);
+    int bits = (int)lround(per_key * HT_LN2);
+    filter->bits = bits < 1 ? 1 : bits > HT_FILTER_MAX_BITS
+                                      ? HT_FILTER_MAX_BITS
+                                      : bits;
+
+    // Number of blocks is rounded up to power of two, the capacity grows
+    // with it
+    int wanted = count * 2 > HT_FILTER_MIN ? count * 2 : HT_FILTER_MIN;
+    double needed = wanted * per_key / HT_FILTER_BLOCK;
+    size_t blocks = 1;
+    while (blocks < needed && blocks <= UINT32_MAX / 2)
+        blocks *= 2;
+    filter->mask = (uint32_t)(blocks - 1);
+    double capacity = blocks * HT_FILTER_BLOCK / per_key;
+    filter->capacity = capacity > INT32_MAX ? INT32_MAX : (int)capacity;
+
+    filter->blocks = aligned_alloc(HT_FILTER_WORDS * sizeof(uint64_t),
+                                   blocks * sizeof(*filter->blocks));
+    if (!filter->blocks) {
+        free(filter);
+        return NULL;
+    }
+    memset(filter->blocks, 0, blocks * sizeof(*filter->blocks));
+    filter->removed = 0;
+    filter->target = target;
+    filter->checks = 0;
+    filter->rejects = 0;
+    filter->false_positives = 0;
+    return filter;
+}
+
+/// @brief Creates empty filter for given number of keys, which replaces
+///        the stale one
+/// @param filter filter to replace, it's freed on success
+/// @param count number of keys to be added
+/// @return created filter with rate and counters of the old one, NULL when
+///         allocation failed and the old filter is kept
+ht_filter_t *ht_filter_resize(ht_filter_t *filter, int count) {
+    ht_filter_t *resized = ht_filter_create(filter->target, count);
+    if (!resized)
+        return NULL;
+    resized->checks = filter->checks;
+    resized->rejects = filter->rejects;
+    resized->false_positives = filter->false_positives;
+    ht_filter_free(filter);
+    return resized;
+}
+
+/// @brief Frees the filter
+/// @param filter filter to free, may be NULL
+void ht_filter_free(ht_filter_t *filter) {
+    if (!filter)
+        return;
+    free(filter->blocks);
+    free(filter);
+}
+
+/// @brief Adds keys of mapped snapshot to the filter
+/// @param filter filter to add to
+/// @param snapshot snapshot whose records which weren't deleted are added
+void ht_filter_add_snapshot(ht_filter_t *filter, ht_snapshot_t *snapshot) {
+    for (uint32_t i = 0; i < snapshot->total; ++i) {
+        if (snapshot->records[i].key)
+            ht_filter_add(filter, snapshot->records[i].hash);
+    }
+}
+
+/// @brief Gets statistics of the filter
+/// @param filter filter to get the statistics of, may be NULL
+/// @param stats set to the statistics, zero when there's no filter
+/// @return bytes allocated by the filter
+size_t ht_filter_stats(ht_filter_t *filter, ht_filter_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!filter)
+        return 0;
+
+    // Key passes when all its bits are set, each is set with probability
+    // of fill of its block
+    size_t blocks = (size_t)filter->mask + 1;
+    double estimate = 0;
+    for (size_t i = 0; i < blocks; ++i) {
+        int set = 0;
+        for (int j = 0; j < HT_FILTER_WORDS; ++j)
+            set += __builtin_popcountll(filter->blocks[i][j]);
+        estimate += pow((double)set / HT_FILTER_BLOCK, filter->bits);
+    }
+    stats->target = filter->target;
+    stats->estimate = estimate / blocks;
+    stats->checks = filter->checks;
+    stats->rejects = filter->rejects;
+    stats->false_positives = filter->false_positives;
+    return sizeof(ht_filter_t) + blocks * sizeof(*filter->blocks);
+}
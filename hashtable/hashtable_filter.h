@@ -0,0 +1,123 @@
+/*
+ * Hlavičkový soubor pro filtr chybějících klíčů.
+ */
+
+#ifndef IAL_HASHTABLE_FILTER_H
+#define IAL_HASHTABLE_FILTER_H
+
+#include "hashtable.h"
+#include "hashtable_snapshot.h"
+
+// Number of 64 bit words of one block, so each block is one cache line
+#define HT_FILTER_WORDS 8
+// Least number of keys the filter is sized for
+#define HT_FILTER_MIN 256
+
+// Blocked Bloom filter, all bits of a key are in one block
+typedef struct ht_filter {
+  uint64_t (*blocks)[HT_FILTER_WORDS]; // bits of the filter
+  uint32_t mask;                       // number of blocks - 1
+  int bits;                            // number of bits set for each key
+  int capacity;                        // number of keys it's sized for
+  int removed;                         // keys deleted since it was built
+  double target;                       // wanted false positive rate
+  uint64_t checks;                     // number of checked keys
+  uint64_t rejects;                    // number of keys rejected
+  uint64_t false_positives;            // keys passed but not found
+} ht_filter_t;
+
+/// @brief Mixes the hash, so bits of the filter don't depend on bits used by
+///        the table
+/// @param hash hash of the key
+/// @return remixed hash, block is chosen by its top bits
+static inline uint64_t ht_filter_mix(uint64_t hash) {
+    return (hash ^ hash >> 29) * 0xbf58476d1ce4e5b9ull;
+}
+
+/// @brief Gets block of the key
+/// @param filter filter to get the block from
+/// @param mixed remixed hash of the key
+/// @return words of the block
+static inline uint64_t *ht_filter_block(ht_filter_t *filter, uint64_t mixed) {
+    return filter->blocks[(mixed >> 32) & filter->mask];
+}
+
+/// @brief Gets position of one bit of the key in its block
+/// @param hash hash of the key
+/// @param i index of the bit
+/// @return position of the bit, 0 to 511
+static inline uint32_t ht_filter_bit(uint64_t hash, int i) {
+    // Positions are generated by double hashing from the other mix
+    uint64_t mixed = hash * 0x9e3779b97f4a7c15ull;
+    uint32_t first = (uint32_t)(mixed >> 32);
+    uint32_t step = (uint32_t)mixed | 1;
+    return (first + (uint32_t)i * step) >> 23;
+}
+
+/// @brief Adds key to the filter
+/// @param filter filter to add to
+/// @param hash hash of the key
+static inline void ht_filter_add(ht_filter_t *filter, uint64_t hash) {
+    uint64_t mixed = ht_filter_mix(hash);
+    uint64_t *block = ht_filter_block(filter, mixed);
+    for (int i = 0; i < filter->bits; ++i) {
+        uint32_t position = ht_filter_bit(hash, i);
+        block[position / 64] |= 1ull << position % 64;
+    }
+}
+
+/// @brief Checks whether the key may be in the table
+/// @param filter filter to check
+/// @param hash hash of the key
+/// @return false when the key surely isn't in the table, else true
+static inline bool ht_filter_check(ht_filter_t *filter, uint64_t hash) {
+    uint64_t mixed = ht_filter_mix(hash);
+    uint64_t *block = ht_filter_block(filter, mixed);
+    ++filter->checks;
+    for (int i = 0; i < filter->bits; ++i) {
+        uint32_t position = ht_filter_bit(hash, i);
+        if (!(block[position / 64] & 1ull << position % 64)) {
+            ++filter->rejects;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Checks whether the filter should be built again
+/// @param filter filter to check
+/// @param count number of keys in the table
+/// @return true when it's too full or has too many deleted keys
+static inline bool ht_filter_stale(ht_filter_t *filter, int count) {
+    return count > filter->capacity || filter->removed > filter->capacity / 2;
+}
+
+/// @brief Checks whether the key may be in the table
+/// @param filter filter of the table, may be NULL
+/// @param hash hash of the key
+/// @return true when the key has to be searched for, else false
+static inline bool ht_filter_pass(ht_filter_t *filter, uint64_t hash) {
+    return !filter || ht_filter_check(filter, hash);
+}
+
+/// @brief Notes that key passed by the filter wasn't found
+/// @param filter filter of the table, may be NULL
+static inline void ht_filter_missed(ht_filter_t *filter) {
+    if (filter)
+        ++filter->false_positives;
+}
+
+/// @brief Notes that key was deleted, its bits stay set
+/// @param filter filter of the table, may be NULL
+static inline void ht_filter_remove(ht_filter_t *filter) {
+    if (filter)
+        ++filter->removed;
+}
+
+ht_filter_t *ht_filter_create(double target, int count);
+ht_filter_t *ht_filter_resize(ht_filter_t *filter, int count);
+void ht_filter_free(ht_filter_t *filter);
+void ht_filter_add_snapshot(ht_filter_t *filter, ht_snapshot_t *snapshot);
+size_t ht_filter_stats(ht_filter_t *filter, ht_filter_stats_t *stats);
+
+#endif
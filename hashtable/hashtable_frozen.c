@@ -0,0 +1,297 @@
+/*
+ * Zmrazená tabulka s rozptýlenými položkami
+ *
+ * Tabulka určená jen pro čtení se sestaví jednou ze všech klíčů běžné
+ * tabulky. Minimální perfektní hashovací funkce (ve stylu CHD/PTHash)
+ * přiřadí každému klíči vlastní místo: klíče se rozdělí do malých košů
+ * a každému koši se najde pilot, se kterým všechny jeho klíče padnou na
+ * volné pozice. Většina klíčů padne do menšiny košů, ty se umisťují první,
+ * dokud je hodně volných pozic. Pozic je o 5 % více než klíčů, aby se
+ * piloti hledali rychle, klíče na pozicích za koncem se přemapují na zbylá
+ * volná místa. Hledání tak spočítá jeden hash, přečte pilota a jedno místo
+ * a porovná klíč.
+ */
+
+#include "hashtable_frozen.h"
+#include "hashtable_snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Average number of keys in one bucket
+#define HT_FROZEN_BUCKET 3
+// Share of keys in dense buckets
+#define HT_FROZEN_DENSE_KEYS 0.6
+// Share of buckets which are dense
+#define HT_FROZEN_DENSE_BUCKETS 0.3
+// Number of keys per one spare position
+#define HT_FROZEN_SPARE 20
+// Max pilot tried for one bucket, the build starts again with other seed
+// when it's reached
+#define HT_FROZEN_MAX_PILOT (1u << 20)
+// Max number of builds with different seeds
+#define HT_FROZEN_ATTEMPTS 8
+
+/// @brief Gets bucket of the key
+/// @param frozen frozen table
+/// @param hash hash of the key
+/// @return index of the bucket
+static inline uint32_t ht_frozen_bucket(const ht_frozen_t *frozen,
+                                        uint64_t hash) {
+    uint64_t mixed = (hash ^ frozen->seed) * 0x9e3779b97f4a7c15ull;
+    // Dense buckets get most of the keys, they're placed while there are
+    // many free positions, the sparse ones fill in the rest
+    uint64_t low = (uint32_t)mixed;
+    if ((mixed >> 32) < HT_FROZEN_DENSE_KEYS * 0x100000000ull)
+        return (uint32_t)((low * frozen->dense) >> 32);
+    return frozen->dense +
+           (uint32_t)((low * (frozen->buckets - frozen->dense)) >> 32);
+}
+
+/// @brief Gets position of the key for given pilot of its bucket
+/// @param frozen frozen table
+/// @param hash hash of the key
+/// @param pilot pilot of the bucket of the key
+/// @return position, less than frozen->positions
+static inline uint32_t ht_frozen_position(const ht_frozen_t *frozen,
+                                          uint64_t hash, uint32_t pilot) {
+    uint64_t mixed = (hash ^ frozen->seed) * 0xbf58476d1ce4e5b9ull;
+    mixed = (mixed ^ (pilot + 1ull) * 0x94d049bb133111ebull) *
+            0x9e3779b97f4a7c15ull;
+    return (uint32_t)(((mixed >> 32) * frozen->positions) >> 32);
+}
+
+/// @brief Tries pilots of one bucket until its keys fit to free positions
+/// @param frozen frozen table, its seed and sizes are set
+/// @param taken bitmap of taken positions, positions of the keys are set
+/// @param hashes hashes of the keys of the bucket
+/// @param size number of keys of the bucket
+/// @param positions set to position of each key
+/// @return pilot, HT_FROZEN_MAX_PILOT when none was found
+static uint32_t ht_frozen_pilot(const ht_frozen_t *frozen, uint64_t *taken,
+                                const uint64_t *hashes, int size,
+                                uint32_t *positions) {
+    for (uint32_t pilot = 0; pilot < HT_FROZEN_MAX_PILOT; ++pilot) {
+        int placed = 0;
+        for (; placed < size; ++placed) {
+            uint32_t position =
+                ht_frozen_position(frozen, hashes[placed], pilot);
+            uint64_t bit = 1ull << position % 64;
+            if (taken[position / 64] & bit)
+                break;
+            // Position is taken at once, so keys of the bucket don't collide
+            taken[position / 64] |= bit;
+            positions[placed] = position;
+        }
+        if (placed == size)
+            return pilot;
+        while (placed--)
+            taken[positions[placed] / 64] &= ~(1ull << positions[placed] % 64);
+    }
+    return HT_FROZEN_MAX_PILOT;
+}
+
+/// @brief Finds pilots of all buckets and slots of all the keys
+/// @param frozen frozen table, its seed and sizes are set, pilots and remap
+///        are allocated
+/// @param entries collected items
+/// @param slots set to slot of each item
+/// @return true on success, false when allocation failed or a bucket has no
+///         pilot with this seed
+static bool ht_frozen_place(ht_frozen_t *frozen,
+                            const ht_snapshot_entry_t *entries,
+                            uint32_t *slots) {
+    uint32_t count = frozen->count;
+    uint32_t buckets = frozen->buckets;
+    uint32_t *starts = calloc(buckets + 2, sizeof(uint32_t));
+    uint32_t *order = malloc((count + 1) * sizeof(uint32_t));
+    uint32_t *sorted = malloc((buckets + 1) * sizeof(uint32_t));
+    uint64_t *taken = calloc(frozen->positions / 64 + 1, sizeof(uint64_t));
+    bool placed = starts && order && sorted && taken;
+
+    uint64_t *hashes = NULL;
+    uint32_t *positions = NULL;
+    uint32_t largest = 0;
+    if (placed) {
+        // Keys are sorted by bucket
+        for (uint32_t i = 0; i < count; ++i)
+            ++starts[ht_frozen_bucket(frozen, entries[i].hash) + 2];
+        for (uint32_t b = 0; b < buckets; ++b) {
+            largest = starts[b + 2] > largest ? starts[b + 2] : largest;
+            starts[b + 2] += starts[b + 1];
+        }
+        for (uint32_t i = 0; i < count; ++i)
+            order[starts[ht_frozen_bucket(frozen, entries[i].hash) + 1]++] = i;
+
+        // Buckets are sorted from the largest one, which is the hardest to
+        // place when the positions fill up
+        uint32_t *sizes = calloc(largest + 2, sizeof(uint32_t));
+        hashes = malloc((largest + 1) * sizeof(uint64_t));
+        positions = malloc((largest + 1) * sizeof(uint32_t));
+        placed = sizes && hashes && positions;
+        if (placed) {
+            for (uint32_t b = 0; b < buckets; ++b)
+                ++sizes[largest - (starts[b + 1] - starts[b]) + 1];
+            for (uint32_t s = 0; s < largest; ++s)
+                sizes[s + 1] += sizes[s];
+            for (uint32_t b = 0; b < buckets; ++b)
+                sorted[sizes[largest - (starts[b + 1] - starts[b])]++] = b;
+        }
+        free(sizes);
+    }
+
+    for (uint32_t i = 0; placed && i < buckets; ++i) {
+        uint32_t b = sorted[i];
+        int size = starts[b + 1] - starts[b];
+        for (int k = 0; k < size; ++k)
+            hashes[k] = entries[order[starts[b] + k]].hash;
+        frozen->pilots[b] = ht_frozen_pilot(frozen, taken, hashes, size,
+                                            positions);
+        placed = frozen->pilots[b] < HT_FROZEN_MAX_PILOT;
+        for (int k = 0; placed && k < size; ++k)
+            slots[order[starts[b] + k]] = positions[k];
+    }
+
+    if (placed) {
+        // Taken positions past the slots move to the free slots, there's
+        // the same number of both
+        uint32_t free_slot = 0;
+        for (uint32_t p = count; p < frozen->positions; ++p) {
+            if (!(taken[p / 64] & 1ull << p % 64))
+                continue;
+            while (taken[free_slot / 64] & 1ull << free_slot % 64)
+                ++free_slot;
+            frozen->remap[p - count] = free_slot++;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (slots[i] >= count)
+                slots[i] = frozen->remap[slots[i] - count];
+        }
+    }
+
+    free(positions);
+    free(hashes);
+    free(taken);
+    free(sorted);
+    free(order);
+    free(starts);
+    return placed;
+}
+
+/// @brief Builds frozen table from the current items of the table
+///
+/// Keys are copied and their stored hashes are reused, the table isn't
+/// changed and can be freed afterwards. Values of the frozen table can be
+/// changed in place, its keys can't.
+///
+/// @param table table to freeze, including items of mapped snapshot
+/// @param frozen set to the frozen table, free it by ht_frozen_free
+/// @return true on success, false when allocation failed or the keys don't
+///         fit 32 bit offsets, the frozen table is then empty
+bool ht_freeze(ht_table_t *table, ht_frozen_t *frozen) {
+    memset(frozen, 0, sizeof(*frozen));
+    int count;
+    ht_snapshot_entry_t *entries = ht_entries(table, &count);
+    if (!entries)
+        return false;
+
+    size_t keys_size = 0;
+    for (int i = 0; i < count; ++i)
+        keys_size += entries[i].length + 1;
+    frozen->count = count;
+    frozen->buckets = count / HT_FROZEN_BUCKET + 1;
+    frozen->dense = frozen->buckets * HT_FROZEN_DENSE_BUCKETS + 1;
+    // Sparse buckets must not be empty, a single bucket is then the sparse
+    // one and the dense keys go to it as well
+    if (frozen->dense >= frozen->buckets)
+        frozen->dense = frozen->buckets - 1;
+    frozen->positions = count + count / HT_FROZEN_SPARE + 1;
+    frozen->pilots = malloc(frozen->buckets * sizeof(uint32_t));
+    // Positions which no key took stay mapped to slot 0, a missing key
+    // landing there is rejected by the key compare
+    frozen->remap = calloc(frozen->positions - count, sizeof(uint32_t));
+    frozen->entries = malloc((count + 1) * sizeof(ht_frozen_entry_t));
+    frozen->keys = malloc(keys_size + 1);
+    frozen->keys_size = keys_size;
+    uint32_t *slots = malloc((count + 1) * sizeof(uint32_t));
+    bool built = keys_size <= UINT32_MAX && frozen->pilots &&
+                     frozen->remap && frozen->entries && frozen->keys && slots;
+
+    // Another seed gives other buckets and positions when a pilot isn't found
+    bool placed = false;
+    for (int attempt = 0; built && !placed && attempt < HT_FROZEN_ATTEMPTS;
+         ++attempt) {
+        frozen->seed = attempt * 0xd6e8feb86659fd93ull;
+        placed = ht_frozen_place(frozen, entries, slots);
+    }
+    built = built && placed;
+
+    size_t offset = 0;
+    for (int i = 0; built && i < count; ++i) {
+        ht_frozen_entry_t *entry = &frozen->entries[slots[i]];
+        entry->check = (uint32_t)(entries[i].hash >> 32);
+        entry->length = entries[i].length;
+        entry->value = entries[i].value;
+        entry->key = (uint32_t)offset;
+        memcpy(frozen->keys + offset, entries[i].key, entries[i].length);
+        frozen->keys[offset + entries[i].length] = 0;
+        offset += entries[i].length + 1;
+    }
+
+    free(slots);
+    free(entries);
+    if (!built)
+        ht_frozen_free(frozen);
+    return built;
+}
+
+/// @brief Gets value of the key from the frozen table
+/// @param frozen table to search in
+/// @param key key of the item
+/// @return pointer to the value, NULL when not found
+float *ht_frozen_get(ht_frozen_t *frozen, const char *key) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    return ht_frozen_get_hashed(frozen, key, length, hash);
+}
+
+/// @brief Gets value of the key and its already computed hash
+/// @param frozen table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return pointer to the value, NULL when not found
+float *ht_frozen_get_hashed(ht_frozen_t *frozen, const char *key,
+                            size_t length, uint64_t hash) {
+    if (!frozen->count)
+        return NULL;
+    uint32_t pilot = frozen->pilots[ht_frozen_bucket(frozen, hash)];
+    uint32_t slot = ht_frozen_position(frozen, hash, pilot);
+    if (slot >= frozen->count)
+        slot = frozen->remap[slot - frozen->count];
+
+    // Every key maps to some slot, so the key itself is verified
+    ht_frozen_entry_t *entry = &frozen->entries[slot];
+    if (entry->check != (uint32_t)(hash >> 32) || entry->length != length ||
+        memcmp(frozen->keys + entry->key, key, length) != 0)
+        return NULL;
+    return &entry->value;
+}
+
+/// @brief Gets memory used by the frozen table
+/// @param frozen frozen table
+/// @return bytes allocated by the table
+size_t ht_frozen_memory(ht_frozen_t *frozen) {
+    return sizeof(ht_frozen_t) + frozen->buckets * sizeof(uint32_t) +
+           (frozen->positions - frozen->count) * sizeof(uint32_t) +
+           frozen->count * sizeof(ht_frozen_entry_t) + frozen->keys_size;
+}
+
+/// @brief Frees the frozen table
+/// @param frozen table to free, it's empty afterwards
+void ht_frozen_free(ht_frozen_t *frozen) {
+    free(frozen->pilots);
+    free(frozen->remap);
+    free(frozen->entries);
+    free(frozen->keys);
+    memset(frozen, 0, sizeof(*frozen));
+}
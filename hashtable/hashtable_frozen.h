@@ -0,0 +1,40 @@
+/*
+ * Hlavičkový soubor pro zmrazenou tabulku s minimální perfektní hashovací
+ * funkcí.
+ */
+
+#ifndef IAL_HASHTABLE_FROZEN_H
+#define IAL_HASHTABLE_FROZEN_H
+
+#include "hashtable.h"
+
+// Item of the frozen table, its key is stored in the pool of keys
+typedef struct ht_frozen_entry {
+  uint32_t check;  // high half of hash of the key, checked before the key
+  uint32_t length; // length of the key
+  float value;     // value of the item
+  uint32_t key;    // offset of the key in the pool
+} ht_frozen_entry_t;
+
+// Read only table, each key has its own slot computed from its hash
+typedef struct ht_frozen {
+  uint32_t count;             // number of items, also number of slots
+  uint32_t buckets;           // number of buckets of keys
+  uint32_t dense;             // number of buckets with most of the keys
+  uint32_t positions;         // number of positions, a bit more than slots
+  uint64_t seed;              // seed of positions, changed when build fails
+  uint32_t *pilots;           // pilot of each bucket, selects positions
+  uint32_t *remap;            // slot of each position which isn't a slot
+  ht_frozen_entry_t *entries; // items in their slots
+  char *keys;                 // pool of keys, each is zero terminated
+  size_t keys_size;           // size of the pool of keys
+} ht_frozen_t;
+
+bool ht_freeze(ht_table_t *table, ht_frozen_t *frozen);
+float *ht_frozen_get(ht_frozen_t *frozen, const char *key);
+float *ht_frozen_get_hashed(ht_frozen_t *frozen, const char *key,
+                            size_t length, uint64_t hash);
+size_t ht_frozen_memory(ht_frozen_t *frozen);
+void ht_frozen_free(ht_frozen_t *frozen);
+
+#endif
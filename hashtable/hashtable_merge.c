@@ -0,0 +1,61 @@
+/*
+ * Slučování tabulek s rozptýlenými položkami
+ *
+ * Položky jedné tabulky se vloží do druhé s již spočítanými hashi, hodnoty
+ * klíčů, které jsou v obou tabulkách, se zkombinují. Používá se ke spojení
+ * tabulek naplněných jednotlivými vlákny, podobně jako ht_build_parallel
+ * ve sdílené tabulce. Položky uložené v tabulce prochází každá
+ * implementace sama (ht_merge_items), položky namapovaného snímku se
+ * slučují zde.
+ */
+
+#include "hashtable_merge.h"
+
+/// @brief Merges one item into the table, its stored hash is reused
+/// @param dst table to merge into
+/// @param key key of the item, it's copied when inserted
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param value value of the item
+/// @param combine combines value in dst with the merged one, NULL when the
+///        merged value replaces it
+void ht_merge_value(ht_table_t *dst, const char *key, size_t length,
+                    uint64_t hash, float value,
+                    float (*combine)(float dst, float src)) {
+    bool inserted;
+    float *found = ht_find_or_insert_hashed(dst, key, length, hash, &inserted);
+    if (found)
+        *found = inserted || !combine ? value : combine(*found, value);
+}
+
+/// @brief Merges records of mapped snapshot into the table
+/// @param dst table to merge into
+/// @param snapshot snapshot whose records which weren't deleted are merged
+/// @param combine combines value in dst with the merged one, may be NULL
+void ht_merge_snapshot(ht_table_t *dst, ht_snapshot_t *snapshot,
+                       float (*combine)(float dst, float src)) {
+    for (uint32_t i = 0; i < snapshot->total; ++i) {
+        ht_snapshot_record_t *record = &snapshot->records[i];
+        if (!record->key)
+            continue;
+        ht_merge_value(dst, (const char *)snapshot->data + record->key,
+                       record->length, record->hash, record->value, combine);
+    }
+}
+
+/// @brief Merges all items of one table into another
+///
+/// Stored hashes of the items are reused, so the keys aren't hashed again.
+/// Keys missing in dst are inserted with their value, values of the others
+/// are combined, e.g. summed when reducing counts of per thread tables.
+///
+/// @param dst table to merge into
+/// @param src table to merge, it isn't changed, mustn't be dst
+/// @param combine combines value in dst with the value in src, NULL when
+///        the value in src replaces it
+void ht_merge(ht_table_t *dst, ht_table_t *src,
+              float (*combine)(float dst, float src)) {
+    if (src->snapshot)
+        ht_merge_snapshot(dst, src->snapshot, combine);
+    ht_merge_items(dst, src, combine);
+}
@@ -0,0 +1,21 @@
+/*
+ * Hlavičkový soubor pro slučování tabulek.
+ */
+
+#ifndef IAL_HASHTABLE_MERGE_H
+#define IAL_HASHTABLE_MERGE_H
+
+#include "hashtable.h"
+#include "hashtable_snapshot.h"
+
+void ht_merge_value(ht_table_t *dst, const char *key, size_t length,
+                    uint64_t hash, float value,
+                    float (*combine)(float dst, float src));
+void ht_merge_snapshot(ht_table_t *dst, ht_snapshot_t *snapshot,
+                       float (*combine)(float dst, float src));
+
+// Implemented by each backend
+void ht_merge_items(ht_table_t *dst, ht_table_t *src,
+                    float (*combine)(float dst, float src));
+
+#endif
@@ -0,0 +1,348 @@
+/*
+ * Tabulka s rozptýlenými položkami čtená bez zámků
+ *
+ * Čtenáři procházejí seznamy synonym bez zámků, zapisovatelé se střídají
+ * pod jedním zámkem. Položky a pole seznamů se zveřejňují atomickým zápisem
+ * ukazatele. Odstraněná položka se uvolní až poté, co ji žádný čtenář nemůže
+ * držet, což se pozná podle epoch (epoch based reclamation).
+ */
+
+#include "hashtable_rcu.h"
+#include <stdlib.h>
+#include <string.h>
+
+/// @brief Allocates empty array of lists
+/// @param size number of lists, power of two
+/// @return allocated array, NULL when allocation failed
+static ht_rcu_lists_t *ht_rcu_alloc_lists(int size) {
+    ht_rcu_lists_t *lists =
+        malloc(sizeof(ht_rcu_lists_t) + size * sizeof(lists->items[0]));
+    if (!lists)
+        return NULL;
+    lists->size = size;
+    lists->retired = NULL;
+    lists->epoch = 0;
+    for (int i = 0; i < size; ++i)
+        atomic_init(&lists->items[i], NULL);
+    return lists;
+}
+
+/// @brief Allocates item with copy of the key
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param value value of the item
+/// @return allocated item, NULL when allocation failed
+static ht_rcu_item_t *ht_rcu_alloc_item(const char *key, size_t length,
+                                        uint64_t hash, float value) {
+    ht_rcu_item_t *item = malloc(sizeof(ht_rcu_item_t) + length + 1);
+    if (!item)
+        return NULL;
+    atomic_init(&item->next, NULL);
+    atomic_init(&item->value, value);
+    item->hash = hash;
+    item->length = length;
+    item->retired = NULL;
+    item->epoch = 0;
+    memcpy(item->key, key, length);
+    item->key[length] = 0;
+    return item;
+}
+
+/// @brief Frees array of lists together with all the items in it
+/// @param lists array to be freed
+static void ht_rcu_free_lists(ht_rcu_lists_t *lists) {
+    for (int i = 0; i < lists->size; ++i) {
+        ht_rcu_item_t *item = atomic_load_explicit(&lists->items[i],
+                                                   memory_order_relaxed);
+        while (item) {
+            ht_rcu_item_t *next =
+                atomic_load_explicit(&item->next, memory_order_relaxed);
+            free(item);
+            item = next;
+        }
+    }
+    free(lists);
+}
+
+/// @brief Advances the epoch if possible and frees what no reader can hold
+///
+/// Epoch can advance only when all the readers inside the table have seen
+/// the current one. Something removed in epoch E can't be reached by any
+/// reader once the epoch is E + 2.
+///
+/// @param table table whose write lock is held
+static void ht_rcu_reclaim(ht_rcu_t *table) {
+    // Removals done before have to be visible before the readers are checked
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t epoch = atomic_load(&table->epoch);
+    bool advance = true;
+    for (int i = 0; i < HT_RCU_READERS && advance; ++i) {
+        uint64_t reader = atomic_load(&table->readers[i].epoch);
+        advance = !(reader & 1) || reader >> 1 == epoch;
+    }
+    if (advance)
+        atomic_store(&table->epoch, ++epoch);
+
+    // Lists of retired things are sorted from newest, so the old ones are
+    // cut off from the first one which can be freed
+    ht_rcu_item_t **item = &table->retired_items;
+    while (*item && (*item)->epoch + 2 > epoch)
+        item = &(*item)->retired;
+    while (*item) {
+        ht_rcu_item_t *next = (*item)->retired;
+        free(*item);
+        *item = next;
+    }
+
+    ht_rcu_lists_t **lists = &table->retired_lists;
+    while (*lists && (*lists)->epoch + 2 > epoch)
+        lists = &(*lists)->retired;
+    while (*lists) {
+        ht_rcu_lists_t *next = (*lists)->retired;
+        ht_rcu_free_lists(*lists);
+        *lists = next;
+    }
+}
+
+/// @brief Replaces array of lists, the old one is freed after grace period
+/// @param table table whose write lock is held
+/// @param lists new array of lists
+static void ht_rcu_replace_lists(ht_rcu_t *table, ht_rcu_lists_t *lists) {
+    ht_rcu_lists_t *old =
+        atomic_load_explicit(&table->lists, memory_order_relaxed);
+    atomic_store_explicit(&table->lists, lists, memory_order_release);
+    old->epoch = atomic_load(&table->epoch);
+    old->retired = table->retired_lists;
+    table->retired_lists = old;
+}
+
+/// @brief Doubles number of lists when there are more items than lists
+///
+/// Readers may be walking the current lists, so the items are copied to the
+/// new array instead of being relinked, and the old array with its items is
+/// retired as a whole.
+///
+/// @param table table whose write lock is held
+static void ht_rcu_grow(ht_rcu_t *table) {
+    ht_rcu_lists_t *old =
+        atomic_load_explicit(&table->lists, memory_order_relaxed);
+    if (table->count <= old->size)
+        return;
+
+    ht_rcu_lists_t *lists = ht_rcu_alloc_lists(old->size * 2);
+    if (!lists)
+        return;
+    for (int i = 0; i < old->size; ++i) {
+        ht_rcu_item_t *item =
+            atomic_load_explicit(&old->items[i], memory_order_relaxed);
+        for (; item;
+             item = atomic_load_explicit(&item->next, memory_order_relaxed)) {
+            ht_rcu_item_t *copy = ht_rcu_alloc_item(
+                item->key, item->length, item->hash,
+                atomic_load_explicit(&item->value, memory_order_relaxed));
+            if (!copy) {
+                ht_rcu_free_lists(lists);
+                return;
+            }
+            // New array isn't visible to readers yet
+            _Atomic(ht_rcu_item_t *) *list =
+                &lists->items[item->hash & (lists->size - 1)];
+            atomic_store_explicit(&copy->next,
+                                  atomic_load_explicit(list,
+                                                       memory_order_relaxed),
+                                  memory_order_relaxed);
+            atomic_store_explicit(list, copy, memory_order_relaxed);
+        }
+    }
+    ht_rcu_replace_lists(table, lists);
+}
+
+/// @brief Initializes table read without locks
+/// @param table table to be initialized
+/// @return true on success, false when allocation failed
+bool ht_rcu_init(ht_rcu_t *table) {
+    // Initial number of lists is HT_SIZE rounded up to power of two
+    int size = 1;
+    while (size < HT_SIZE)
+        size *= 2;
+    ht_rcu_lists_t *lists = ht_rcu_alloc_lists(size);
+    if (!lists)
+        return false;
+
+    atomic_init(&table->lists, lists);
+    atomic_init(&table->epoch, 0);
+    for (int i = 0; i < HT_RCU_READERS; ++i) {
+        atomic_init(&table->readers[i].epoch, 0);
+        atomic_init(&table->readers[i].used, false);
+    }
+    pthread_mutex_init(&table->write_lock, NULL);
+    table->count = 0;
+    table->retired_items = NULL;
+    table->retired_lists = NULL;
+    return true;
+}
+
+/// @brief Registers calling thread as reader of the table
+/// @param table table to be read
+/// @return reader slot owned by the thread, NULL when all slots are used
+ht_rcu_reader_t *ht_rcu_register(ht_rcu_t *table) {
+    for (int i = 0; i < HT_RCU_READERS; ++i) {
+        bool used = false;
+        if (atomic_compare_exchange_strong(&table->readers[i].used, &used,
+                                           true))
+            return &table->readers[i];
+    }
+    return NULL;
+}
+
+/// @brief Releases reader slot so other thread can use it
+/// @param reader slot which isn't inside the table
+void ht_rcu_unregister(ht_rcu_reader_t *reader) {
+    atomic_store(&reader->epoch, 0);
+    atomic_store(&reader->used, false);
+}
+
+/// @brief Marks start of reading, found items stay valid until ht_rcu_leave
+///
+/// Reader only writes its own slot, it never waits for writers.
+///
+/// @param table table to be read
+/// @param reader slot of the calling thread
+void ht_rcu_enter(ht_rcu_t *table, ht_rcu_reader_t *reader) {
+    uint64_t epoch = atomic_load_explicit(&table->epoch, memory_order_relaxed);
+    atomic_store_explicit(&reader->epoch, epoch * 2 + 1, memory_order_relaxed);
+    // Epoch has to be published before any item is read
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/// @brief Marks end of reading, found items may be freed afterwards
+/// @param reader slot of the calling thread
+void ht_rcu_leave(ht_rcu_reader_t *reader) {
+    atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
+
+/// @brief Searches for item, has to be called between enter and leave
+/// @param table table to search in
+/// @param key key of the item
+/// @return found item, NULL when not found
+ht_rcu_item_t *ht_rcu_search(ht_rcu_t *table, char *key) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_rcu_lists_t *lists =
+        atomic_load_explicit(&table->lists, memory_order_acquire);
+    ht_rcu_item_t *item = atomic_load_explicit(
+        &lists->items[hash & (lists->size - 1)], memory_order_acquire);
+    for (; item;
+         item = atomic_load_explicit(&item->next, memory_order_acquire)) {
+        if (item->hash == hash && item->length == length &&
+            memcmp(item->key, key, length) == 0)
+            return item;
+    }
+    return NULL;
+}
+
+/// @brief Gets value of the item without locking
+/// @param table table to search in
+/// @param reader slot of the calling thread
+/// @param key key of the item
+/// @param value set to the value when found
+/// @return true when found, else false
+bool ht_rcu_get(ht_rcu_t *table, ht_rcu_reader_t *reader, char *key,
+                float *value) {
+    ht_rcu_enter(table, reader);
+    ht_rcu_item_t *found = ht_rcu_search(table, key);
+    if (found)
+        *value = atomic_load_explicit(&found->value, memory_order_relaxed);
+    ht_rcu_leave(reader);
+    return found != NULL;
+}
+
+/// @brief Inserts item, waits for other writers but never for readers
+/// @param table table to insert to
+/// @param key key of the item, it's copied
+/// @param value value of the item, replaces value of existing item
+void ht_rcu_insert(ht_rcu_t *table, char *key, float value) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    pthread_mutex_lock(&table->write_lock);
+
+    // Writer holds the lock, so nothing it reads can be freed meanwhile
+    ht_rcu_item_t *found = ht_rcu_search(table, key);
+    if (found) {
+        atomic_store_explicit(&found->value, value, memory_order_relaxed);
+        pthread_mutex_unlock(&table->write_lock);
+        return;
+    }
+
+    ht_rcu_item_t *item = ht_rcu_alloc_item(key, length, hash, value);
+    if (item) {
+        ht_rcu_lists_t *lists =
+            atomic_load_explicit(&table->lists, memory_order_relaxed);
+        _Atomic(ht_rcu_item_t *) *list =
+            &lists->items[hash & (lists->size - 1)];
+        atomic_store_explicit(&item->next,
+                              atomic_load_explicit(list, memory_order_relaxed),
+                              memory_order_relaxed);
+        // Item is fully initialized before readers can see it
+        atomic_store_explicit(list, item, memory_order_release);
+        ++table->count;
+        ht_rcu_grow(table);
+    }
+    ht_rcu_reclaim(table);
+    pthread_mutex_unlock(&table->write_lock);
+}
+
+/// @brief Deletes item, it's freed once no reader can hold it
+/// @param table table to delete from
+/// @param key key of the item
+void ht_rcu_delete(ht_rcu_t *table, char *key) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    pthread_mutex_lock(&table->write_lock);
+
+    ht_rcu_lists_t *lists =
+        atomic_load_explicit(&table->lists, memory_order_relaxed);
+    _Atomic(ht_rcu_item_t *) *prev = &lists->items[hash & (lists->size - 1)];
+    for (ht_rcu_item_t *item; (item = atomic_load_explicit(
+                                   prev, memory_order_relaxed));
+         prev = &item->next) {
+        if (item->hash != hash || item->length != length ||
+            memcmp(item->key, key, length) != 0)
+            continue;
+
+        // Readers standing on the item can still continue past it
+        atomic_store_explicit(
+            prev, atomic_load_explicit(&item->next, memory_order_relaxed),
+            memory_order_release);
+        item->epoch = atomic_load(&table->epoch);
+        item->retired = table->retired_items;
+        table->retired_items = item;
+        --table->count;
+        break;
+    }
+    ht_rcu_reclaim(table);
+    pthread_mutex_unlock(&table->write_lock);
+}
+
+/// @brief Deletes all the items and frees the table
+///
+/// Unlike other writes, no thread may be inside the table during this call.
+///
+/// @param table table to be freed
+void ht_rcu_delete_all(ht_rcu_t *table) {
+    ht_rcu_free_lists(atomic_load(&table->lists));
+    while (table->retired_items) {
+        ht_rcu_item_t *next = table->retired_items->retired;
+        free(table->retired_items);
+        table->retired_items = next;
+    }
+    while (table->retired_lists) {
+        ht_rcu_lists_t *next = table->retired_lists->retired;
+        ht_rcu_free_lists(table->retired_lists);
+        table->retired_lists = next;
+    }
+    pthread_mutex_destroy(&table->write_lock);
+    atomic_store(&table->lists, NULL);
+    table->count = 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Hlavičkový soubor pro tabulku čtenou bez zámků.
+ */
+
+#ifndef IAL_HASHTABLE_RCU_H
+#define IAL_HASHTABLE_RCU_H
+
+#include "hashtable.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Max number of threads registered as readers of one table at once
+#define HT_RCU_READERS 64
+
+// Prvok tabuľky
+typedef struct ht_rcu_item {
+  _Atomic(struct ht_rcu_item *) next; // ukazateľ na ďalšie synonymum
+  uint64_t hash;                      // full hash of the key
+  _Atomic float value;                // hodnota prvku
+  uint32_t length;                    // length of the key
+  struct ht_rcu_item *retired;        // next item waiting to be freed
+  uint64_t epoch;                     // epoch in which it was removed
+  char key[];                         // kľúč prvku
+} ht_rcu_item_t;
+
+// Array of lists of synonyms, replaced as a whole when the table grows
+typedef struct ht_rcu_lists {
+  int size;                      // number of lists, power of two
+  struct ht_rcu_lists *retired;  // next array waiting to be freed
+  uint64_t epoch;                // epoch in which it was replaced
+  _Atomic(ht_rcu_item_t *) items[]; // lists of synonyms
+} ht_rcu_lists_t;
+
+// Reader of the table, each on its own cache line
+typedef struct ht_rcu_reader {
+  _Alignas(64) _Atomic uint64_t epoch; // epoch * 2 + 1 when reading, else 0
+  atomic_bool used;                    // whether some thread owns the slot
+} ht_rcu_reader_t;
+
+// Table whose readers never lock, writers are serialized
+typedef struct ht_rcu {
+  _Atomic(ht_rcu_lists_t *) lists;         // current lists of synonyms
+  _Atomic uint64_t epoch;                  // global epoch
+  ht_rcu_reader_t readers[HT_RCU_READERS]; // slots of registered readers
+  pthread_mutex_t write_lock;              // serializes writers
+  int count;                               // number of items
+  ht_rcu_item_t *retired_items;            // removed items, newest first
+  ht_rcu_lists_t *retired_lists;           // replaced arrays, newest first
+} ht_rcu_t;
+
+bool ht_rcu_init(ht_rcu_t *table);
+ht_rcu_reader_t *ht_rcu_register(ht_rcu_t *table);
+void ht_rcu_unregister(ht_rcu_reader_t *reader);
+void ht_rcu_enter(ht_rcu_t *table, ht_rcu_reader_t *reader);
+void ht_rcu_leave(ht_rcu_reader_t *reader);
+ht_rcu_item_t *ht_rcu_search(ht_rcu_t *table, char *key);
+bool ht_rcu_get(ht_rcu_t *table, ht_rcu_reader_t *reader, char *key,
+                float *value);
+void ht_rcu_insert(ht_rcu_t *table, char *key, float value);
+void ht_rcu_delete(ht_rcu_t *table, char *key);
+void ht_rcu_delete_all(ht_rcu_t *table);
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Tabulka s rozptýlenými položkami sdílená mezi vlákny
+ *
+ * Klíče jsou podle horních bitů hashe rozděleny mezi části (shards), každá
+ * část je samostatná tabulka se svým zámkem. Vlákna pracující s různými
+ * částmi na sebe nečekají.
+ *
+ * Hromadné sestavení rozdělí položky podle stejných bitů hashe (radix
+ * partitioning) a každou část naplní jedno vlákno bez zamykání.
+ */
+
+#include "hashtable_shared.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Shift of the hash bits which select the shard, lower bits select the list
+#define HT_SHARD_SHIFT 40
+
+/// @brief Gets shard of the key with given hash
+/// @param table shared table
+/// @param hash hash of the key
+/// @return shard which contains the key
+static inline ht_shard_t *ht_shard(ht_shared_t *table, uint64_t hash) {
+    return &table->shards[(hash >> HT_SHARD_SHIFT) & table->mask];
+}
+
+/// @brief Initializes shared table
+/// @param table table to be initialized
+/// @param shards number of shards, rounded up to power of two
+/// @return true on success, false when allocation failed
+bool ht_shared_init(ht_shared_t *table, int shards) {
+    int count = 1;
+    while (count < shards)
+        count *= 2;
+
+    table->shards = aligned_alloc(_Alignof(ht_shard_t),
+                                  count * sizeof(ht_shard_t));
+    if (!table->shards)
+        return false;
+    table->mask = count - 1;
+    for (int i = 0; i < count; ++i) {
+        pthread_mutex_init(&table->shards[i].lock, NULL);
+        ht_init(&table->shards[i].table);
+    }
+    return true;
+}
+
+// Work of one thread of ht_build_parallel
+typedef struct ht_build {
+  ht_shared_t *table;     // table being built
+  const ht_pair_t *items; // all the items
+  uint64_t *hashes;       // hash of each item
+  size_t *lengths;        // length of key of each item
+  int *order;             // indexes of items sorted by shard
+  const int *starts;      // first index in order of each shard and the end
+  int *offsets;           // items of each shard in the range of the thread,
+                          // then next index in order for each shard
+  int start;              // first item of the range of the thread
+  int end;                // end of the range of the thread
+  int thread;             // index of the thread
+  int threads;            // number of the threads
+  pthread_t id;           // the thread, when it was started
+  bool started;           // whether the thread was started
+} ht_build_t;
+
+/// @brief Gets index of shard of the key with given hash
+/// @param table shared table
+/// @param hash hash of the key
+/// @return index of the shard
+static inline int ht_shard_index(ht_shared_t *table, uint64_t hash) {
+    return (int)(ht_shard(table, hash) - table->shards);
+}
+
+/// @brief Hashes items in the range of the thread and counts them by shard
+/// @param arg ht_build_t of the thread
+/// @return NULL
+static void *ht_build_hash(void *arg) {
+    ht_build_t *work = arg;
+    for (int i = work->start; i < work->end; ++i) {
+        work->hashes[i] = ht_hash(work->items[i].key, &work->lengths[i]);
+        ++work->offsets[ht_shard_index(work->table, work->hashes[i])];
+    }
+    return NULL;
+}
+
+/// @brief Writes indexes of items in the range of the thread to their shards
+/// @param arg ht_build_t of the thread
+/// @return NULL
+static void *ht_build_scatter(void *arg) {
+    ht_build_t *work = arg;
+    // Items of a shard keep their order, so later duplicate wins like with
+    // inserts one by one
+    for (int i = work->start; i < work->end; ++i) {
+        int shard = ht_shard_index(work->table, work->hashes[i]);
+        work->order[work->offsets[shard]++] = i;
+    }
+    return NULL;
+}
+
+/// @brief Inserts items of shards of the thread, no other thread uses them
+/// @param arg ht_build_t of the thread
+/// @return NULL
+static void *ht_build_insert(void *arg) {
+    ht_build_t *work = arg;
+    for (int shard = work->thread; shard <= work->table->mask;
+         shard += work->threads) {
+        ht_table_t *table = &work->table->shards[shard].table;
+        for (int j = work->starts[shard]; j < work->starts[shard + 1]; ++j) {
+            int i = work->order[j];
+            ht_insert_hashed(table, work->items[i].key, work->lengths[i],
+                             work->hashes[i], work->items[i].value);
+        }
+    }
+    return NULL;
+}
+
+/// @brief Runs one phase of ht_build_parallel on all the threads
+/// @param work work of each thread
+/// @param threads number of the threads
+/// @param phase function run by each thread
+static void ht_build_run(ht_build_t *work, int threads,
+                         void *(*phase)(void *)) {
+    // Calling thread does the first part, parts of threads which couldn't
+    // be started are done by it too
+    for (int t = 1; t < threads; ++t)
+        work[t].started =
+            pthread_create(&work[t].id, NULL, phase, &work[t]) == 0;
+    phase(&work[0]);
+    for (int t = 1; t < threads; ++t) {
+        if (work[t].started)
+            pthread_join(work[t].id, NULL);
+        else
+            phase(&work[t]);
+    }
+}
+
+/// @brief Builds shared table from many items at once
+///
+/// Items are hashed in parallel, partitioned by the bits of hash which
+/// select the shard, and each shard is then filled by one thread without
+/// locking. Result is the same as inserting the items one by one.
+///
+/// @param table table to be initialized, with a shard for each thread
+/// @param items items to insert, later one wins when keys are duplicate
+/// @param n number of the items
+/// @param threads number of threads to use
+/// @return true on success, false when allocation failed and the table
+///         isn't initialized
+bool ht_build_parallel(ht_shared_t *table, const ht_pair_t *items, int n,
+                       int threads) {
+    if (threads < 1)
+        threads = 1;
+    if (!ht_shared_init(table, threads))
+        return false;
+    int shards = table->mask + 1;
+
+    // One more element of each array, so nothing is allocated with size 0
+    ht_build_t *work = malloc(threads * sizeof(ht_build_t));
+    uint64_t *hashes = malloc((n + 1) * sizeof(uint64_t));
+    size_t *lengths = malloc((n + 1) * sizeof(size_t));
+    int *order = malloc((n + 1) * sizeof(int));
+    int *offsets = calloc((size_t)threads * shards, sizeof(int));
+    int *starts = malloc((shards + 1) * sizeof(int));
+    bool built = work && hashes && lengths && order && offsets && starts;
+    if (built) {
+        for (int t = 0; t < threads; ++t) {
+            ht_build_t *part = &work[t];
+            part->table = table;
+            part->items = items;
+            part->hashes = hashes;
+            part->lengths = lengths;
+            part->order = order;
+            part->starts = starts;
+            part->offsets = offsets + (size_t)t * shards;
+            part->start = (int)((long long)n * t / threads);
+            part->end = (int)((long long)n * (t + 1) / threads);
+            part->thread = t;
+            part->threads = threads;
+        }
+        ht_build_run(work, threads, ht_build_hash);
+
+        // Counts become offsets, ranges of the threads follow each other
+        // within each shard
+        int offset = 0;
+        for (int shard = 0; shard < shards; ++shard) {
+            starts[shard] = offset;
+            for (int t = 0; t < threads; ++t) {
+                int count = work[t].offsets[shard];
+                work[t].offsets[shard] = offset;
+                offset += count;
+            }
+        }
+        starts[shards] = offset;
+
+        ht_build_run(work, threads, ht_build_scatter);
+        ht_build_run(work, threads, ht_build_insert);
+    } else {
+        ht_shared_delete_all(table);
+    }
+
+    free(starts);
+    free(offsets);
+    free(order);
+    free(lengths);
+    free(hashes);
+    free(work);
+    return built;
+}
+
+/// @brief Inserts item into the shared table
+/// @param table table to insert to
+/// @param key key of the item, it's copied
+/// @param value value of the item, replaces value of existing item
+void ht_shared_insert(ht_shared_t *table, char *key, float value) {
+    // Key is hashed outside of the lock, the shard uses the same hash
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_shard_t *shard = ht_shard(table, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    ht_insert_hashed(&shard->table, key, length, hash, value);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/// @brief Gets value of the item from the shared table
+/// @param table table to search in
+/// @param key key of the item
+/// @param value set to copy of the value when found
+/// @return true when found, else false
+bool ht_shared_get(ht_shared_t *table, char *key, float *value) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_shard_t *shard = ht_shard(table, hash);
+
+    // Value is copied, pointer into the table isn't valid after unlocking
+    pthread_mutex_lock(&shard->lock);
+    ht_item_t *found = ht_search_hashed(&shard->table, key, length, hash);
+    if (found)
+        *value = HT_VALUE(found);
+    pthread_mutex_unlock(&shard->lock);
+    return found != NULL;
+}
+
+/// @brief Atomically adds to the value of the item
+/// @param table table containing the item
+/// @param key key of the item, inserted with value 0 when it doesn't exist
+/// @param delta number added to the value
+/// @return new value of the item, NaN when allocation failed
+float ht_shared_add(ht_shared_t *table, char *key, float delta) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_shard_t *shard = ht_shard(table, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    float value = NAN;
+    float *found =
+        ht_find_or_insert_hashed(&shard->table, key, length, hash, NULL);
+    if (found)
+        value = *found += delta;
+    pthread_mutex_unlock(&shard->lock);
+    return value;
+}
+
+/// @brief Deletes item from the shared table
+/// @param table table to delete from
+/// @param key key of the item
+void ht_shared_delete(ht_shared_t *table, char *key) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_shard_t *shard = ht_shard(table, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    ht_delete_hashed(&shard->table, key, length, hash);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/// @brief Deletes all the items and frees the shards
+///
+/// No other thread may use the table during and after this call, until it's
+/// initialized again.
+///
+/// @param table table to be freed
+void ht_shared_delete_all(ht_shared_t *table) {
+    for (int i = 0; i <= table->mask; ++i) {
+        ht_delete_all(&table->shards[i].table);
+        pthread_mutex_destroy(&table->shards[i].lock);
+    }
+    free(table->shards);
+    table->shards = NULL;
+    table->mask = 0;
+}
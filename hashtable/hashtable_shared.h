@@ -0,0 +1,39 @@
+/*
+ * Hlavičkový soubor pro tabulku sdílenou mezi vlákny.
+ */
+
+#ifndef IAL_HASHTABLE_SHARED_H
+#define IAL_HASHTABLE_SHARED_H
+
+#include "hashtable.h"
+#include <pthread.h>
+
+// Part of the shared table with its own lock
+typedef struct ht_shard {
+  // lock of the shard, shards are aligned so locks don't share cache lines
+  _Alignas(64) pthread_mutex_t lock;
+  ht_table_t table; // items whose hash maps to the shard
+} ht_shard_t;
+
+// Table which can be used by many threads at once
+typedef struct ht_shared {
+  ht_shard_t *shards; // parts of the table
+  int mask;           // number of shards - 1, the number is power of two
+} ht_shared_t;
+
+// Key and value of an item of ht_build_parallel
+typedef struct ht_pair {
+  const char *key; // key of the item, it's copied
+  float value;     // value of the item
+} ht_pair_t;
+
+bool ht_shared_init(ht_shared_t *table, int shards);
+bool ht_build_parallel(ht_shared_t *table, const ht_pair_t *items, int n,
+                       int threads);
+void ht_shared_insert(ht_shared_t *table, char *key, float value);
+bool ht_shared_get(ht_shared_t *table, char *key, float *value);
+float ht_shared_add(ht_shared_t *table, char *key, float delta);
+void ht_shared_delete(ht_shared_t *table, char *key);
+void ht_shared_delete_all(ht_shared_t *table);
+
+#endif
@@ -0,0 +1,352 @@
+/*
+ * Snímek tabulky s rozptýlenými položkami
+ *
+ * Tabulka se uloží do souboru, ve kterém jsou místo ukazatelů posunutí od
+ * začátku souboru. Soubor se pak jen namapuje do paměti a hledá se přímo
+ * v něm, takže se při startu nic nevkládá. Mapování je soukromé, zápisy do
+ * něj se tedy kopírují (copy-on-write) a soubor se nemění.
+ *
+ * Čísla jsou uložena v pořadí bajtů počítače, který soubor zapsal.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hashtable_snapshot.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// @brief Checks whether header of mapped file describes valid snapshot
+/// @param header header at start of the file
+/// @param size size of the file
+/// @return true when the snapshot can be used, else false
+static bool ht_snapshot_valid(const ht_snapshot_header_t *header,
+                              size_t size) {
+    if (memcmp(header->magic, HT_SNAPSHOT_MAGIC, sizeof(header->magic)))
+        return false;
+    // Hashes can't be used with different seed
+    if (header->seed != HT_SEED || header->size != size)
+        return false;
+    if (!header->buckets || header->buckets & (header->buckets - 1))
+        return false;
+    // Only the sections are checked, their contents are read lazily
+    if (header->starts % sizeof(uint32_t) ||
+        header->records % sizeof(uint64_t))
+        return false;
+    return header->starts + (header->buckets + 1ull) * sizeof(uint32_t) <=
+               header->records &&
+           header->records + header->count * sizeof(ht_snapshot_record_t) <=
+               size;
+}
+
+/// @brief Maps snapshot file to memory
+/// @param path path of the file written by ht_save
+/// @return mapped snapshot, NULL when the file can't be used
+ht_snapshot_t *ht_snapshot_map(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat info;
+    if (fstat(fd, &info) < 0 ||
+        (size_t)info.st_size < sizeof(ht_snapshot_header_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    // Private writable mapping, changed pages are copied for this process
+    size_t size = info.st_size;
+    void *data =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+    const ht_snapshot_header_t *header = data;
+    ht_snapshot_t *snapshot = malloc(sizeof(ht_snapshot_t));
+    if (!snapshot || !ht_snapshot_valid(header, size)) {
+        free(snapshot);
+        munmap(data, size);
+        return NULL;
+    }
+    // Lookups jump around the file, so reading ahead would be wasted
+    posix_madvise(data, size, POSIX_MADV_RANDOM);
+
+    snapshot->data = data;
+    snapshot->size = size;
+    snapshot->mask = header->buckets - 1;
+    snapshot->starts = (const uint32_t *)(snapshot->data + header->starts);
+    snapshot->records =
+        (ht_snapshot_record_t *)(snapshot->data + header->records);
+    snapshot->total = header->count;
+    snapshot->count = header->count;
+    return snapshot;
+}
+
+/// @brief Unmaps the snapshot, changes of it are lost
+/// @param snapshot snapshot to unmap, may be NULL
+void ht_snapshot_unmap(ht_snapshot_t *snapshot) {
+    if (!snapshot)
+        return;
+    munmap(snapshot->data, snapshot->size);
+    free(snapshot);
+}
+
+/// @brief Prefetches bucket of the hash, so its search waits less
+/// @param snapshot snapshot to be searched
+/// @param hash hash of the key
+void ht_snapshot_prefetch(ht_snapshot_t *snapshot, uint64_t hash) {
+    __builtin_prefetch(snapshot->starts + (hash & snapshot->mask));
+}
+
+/// @brief Searches for record with given key
+/// @param snapshot snapshot to search in
+/// @param key key of the record
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return found record, NULL when not found
+ht_snapshot_record_t *ht_snapshot_search(ht_snapshot_t *snapshot,
+                                         const char *key, size_t length,
+                                         uint64_t hash) {
+    uint32_t bucket = hash & snapshot->mask;
+    uint32_t end = snapshot->starts[bucket + 1];
+    // Broken index must not lead out of the records
+    if (end > snapshot->total)
+        end = snapshot->total;
+
+    for (uint32_t i = snapshot->starts[bucket]; i < end; ++i) {
+        ht_snapshot_record_t *record = &snapshot->records[i];
+        if (record->hash != hash || !record->key || record->length != length)
+            continue;
+        if (record->key + length < snapshot->size &&
+            memcmp(snapshot->data + record->key, key, length) == 0)
+            return record;
+    }
+    return NULL;
+}
+
+/// @brief Removes record with given key from the snapshot
+///
+/// Used when the item moves to the table, so it can be changed there.
+///
+/// @param snapshot snapshot to remove from
+/// @param key key of the record
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param value set to value of the removed record, may be NULL
+/// @return true when the record was found, else false
+bool ht_snapshot_take(ht_snapshot_t *snapshot, const char *key, size_t length,
+                      uint64_t hash, float *value) {
+    ht_snapshot_record_t *record =
+        ht_snapshot_search(snapshot, key, length, hash);
+    if (!record)
+        return false;
+    if (value)
+        *value = record->value;
+    ht_snapshot_remove(snapshot, record);
+    return true;
+}
+
+/// @brief Removes found record from the snapshot
+///
+/// Used after the item was added to the table, so the key isn't lost when
+/// the table can't allocate it.
+///
+/// @param snapshot snapshot to remove from
+/// @param record record of the snapshot found by ht_snapshot_search
+void ht_snapshot_remove(ht_snapshot_t *snapshot,
+                        ht_snapshot_record_t *record) {
+    record->key = 0;
+    --snapshot->count;
+}
+
+/// @brief Calls function with value of each record which wasn't removed
+/// @param snapshot snapshot to go through
+/// @param fn function to call, NaN values are skipped
+/// @param data passed to the function
+void ht_snapshot_for_each_value(ht_snapshot_t *snapshot,
+                                void (*fn)(float value, void *data),
+                                void *data) {
+    for (uint32_t i = 0; i < snapshot->total; ++i) {
+        ht_snapshot_record_t *record = &snapshot->records[i];
+        if (record->key && !isnan(record->value))
+            fn(record->value, data);
+    }
+}
+
+/// @brief Gets next record which wasn't removed, used by iterators
+/// @param snapshot snapshot to go through
+/// @param index index of the next record, moved past the returned one
+/// @param key set to key of the record
+/// @param value set to value of the record
+/// @return false when there are no more records, else true
+bool ht_snapshot_next(ht_snapshot_t *snapshot, uint32_t *index,
+                      const char **key, float **value) {
+    while (*index < snapshot->total) {
+        ht_snapshot_record_t *record = &snapshot->records[(*index)++];
+        if (!record->key)
+            continue;
+        *key = (const char *)snapshot->data + record->key;
+        *value = &record->value;
+        return true;
+    }
+    return false;
+}
+
+/// @brief Collects records of the snapshot which weren't removed
+/// @param snapshot snapshot to collect from
+/// @param entries buffer for at least snapshot->count entries
+/// @return number of collected entries
+int ht_snapshot_entries(ht_snapshot_t *snapshot,
+                        ht_snapshot_entry_t *entries) {
+    int count = 0;
+    for (uint32_t i = 0; i < snapshot->total; ++i) {
+        ht_snapshot_record_t *record = &snapshot->records[i];
+        if (!record->key)
+            continue;
+        entries[count].key = (const char *)snapshot->data + record->key;
+        entries[count].hash = record->hash;
+        entries[count].length = record->length;
+        entries[count].value = record->value;
+        ++count;
+    }
+    return count;
+}
+
+/// @brief Writes the sections of the snapshot file
+/// @param file file to write to
+/// @param header header of the snapshot
+/// @param starts index of first record of each bucket
+/// @param entries collected items
+/// @param order indexes of entries sorted by bucket
+/// @return true when everything was written, else false
+static bool ht_snapshot_write_file(FILE *file,
+                                   const ht_snapshot_header_t *header,
+                                   const uint32_t *starts,
+                                   ht_snapshot_entry_t *entries,
+                                   const int *order) {
+    static const char padding[sizeof(uint64_t)];
+    size_t index = (header->buckets + 1ull) * sizeof(uint32_t);
+    size_t pad = header->records - header->starts - index;
+    if (fwrite(header, sizeof(*header), 1, file) != 1 ||
+        fwrite(starts, index, 1, file) != 1 ||
+        fwrite(padding, 1, pad, file) != pad)
+        return false;
+
+    // Keys are stored after the records in the same order
+    uint64_t key = header->records +
+                   header->count * sizeof(ht_snapshot_record_t);
+    for (uint32_t i = 0; i < header->count; ++i) {
+        ht_snapshot_entry_t *entry = &entries[order[i]];
+        ht_snapshot_record_t record = {entry->hash, key, entry->length,
+                                       entry->value};
+        if (fwrite(&record, sizeof(record), 1, file) != 1)
+            return false;
+        key += entry->length + 1;
+    }
+    for (uint32_t i = 0; i < header->count; ++i) {
+        ht_snapshot_entry_t *entry = &entries[order[i]];
+        if (fwrite(entry->key, 1, entry->length, file) != entry->length ||
+            fputc(0, file) == EOF)
+            return false;
+    }
+    return true;
+}
+
+/// @brief Writes items to snapshot file
+///
+/// The file is written next to the target and renamed over it at the end,
+/// so the old snapshot stays valid (even while it's mapped) until the new one
+/// is complete.
+///
+/// @param path path of the file
+/// @param entries items to write
+/// @param count number of the items
+/// @return true when the snapshot was written, else false
+bool ht_snapshot_write(const char *path, ht_snapshot_entry_t *entries,
+                       int count) {
+    // At most one record per bucket on average
+    uint32_t buckets = 1;
+    while (buckets < (uint32_t)count)
+        buckets *= 2;
+
+    ht_snapshot_header_t header;
+    memcpy(header.magic, HT_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.seed = HT_SEED;
+    header.buckets = buckets;
+    header.count = count;
+    header.starts = sizeof(header);
+    header.records = header.starts + (buckets + 1ull) * sizeof(uint32_t);
+    header.records = (header.records + 7) / 8 * 8;
+    header.size = header.records + count * sizeof(ht_snapshot_record_t);
+    for (int i = 0; i < count; ++i)
+        header.size += entries[i].length + 1;
+
+    uint32_t *starts = calloc(buckets + 1, sizeof(uint32_t));
+    uint32_t *next = malloc(buckets * sizeof(uint32_t));
+    int *order = malloc((count + 1) * sizeof(int));
+    char *temp = malloc(strlen(path) + sizeof(".tmp"));
+    FILE *file = NULL;
+    if (starts && next && order && temp) {
+        strcpy(temp, path);
+        strcat(temp, ".tmp");
+        file = fopen(temp, "wb");
+    }
+    bool written = false;
+    if (file) {
+        // Entries are sorted by bucket using counting sort
+        for (int i = 0; i < count; ++i)
+            ++starts[(entries[i].hash & (buckets - 1)) + 1];
+        for (uint32_t i = 0; i < buckets; ++i)
+            starts[i + 1] += starts[i];
+        memcpy(next, starts, buckets * sizeof(uint32_t));
+        for (int i = 0; i < count; ++i)
+            order[next[entries[i].hash & (buckets - 1)]++] = i;
+
+        written =
+            ht_snapshot_write_file(file, &header, starts, entries, order);
+        written = fclose(file) == 0 && written;
+        written = written && rename(temp, path) == 0;
+        if (!written)
+            remove(temp);
+    }
+
+    free(temp);
+    free(order);
+    free(next);
+    free(starts);
+    return written;
+}
+
+/// @brief Saves the table to snapshot file, which can be opened by
+///        ht_open_mapped
+/// @param table table to save
+/// @param path path of the file, it's replaced when it exists
+/// @return true when the table was saved, else false
+bool ht_save(ht_table_t *table, const char *path) {
+    int count;
+    ht_snapshot_entry_t *entries = ht_entries(table, &count);
+    if (!entries)
+        return false;
+    bool saved = ht_snapshot_write(path, entries, count);
+    free(entries);
+    return saved;
+}
+
+/// @brief Opens table saved by ht_save
+///
+/// The table is searched directly in the mapped file. Changed values stay
+/// in the mapping, new items are inserted to the table as usual.
+///
+/// @param table table to initialize
+/// @param path path of the snapshot
+/// @return true when the snapshot was mapped, else false and the table is
+///         empty
+bool ht_open_mapped(ht_table_t *table, const char *path) {
+    ht_init(table);
+    table->snapshot = ht_snapshot_map(path);
+    return table->snapshot != NULL;
+}
@@ -0,0 +1,74 @@
+/*
+ * Hlavičkový soubor pro snímek tabulky uložený v souboru.
+ */
+
+#ifndef IAL_HASHTABLE_SNAPSHOT_H
+#define IAL_HASHTABLE_SNAPSHOT_H
+
+#include "hashtable.h"
+
+// Identifies snapshot files and version of their format
+#define HT_SNAPSHOT_MAGIC "IALHTSN1"
+
+// Start of the snapshot file, all offsets are from start of the file
+typedef struct ht_snapshot_header {
+  char magic[8];    // HT_SNAPSHOT_MAGIC
+  uint64_t seed;    // HT_SEED the hashes were computed with
+  uint64_t size;    // size of the whole file
+  uint32_t buckets; // number of buckets, power of two
+  uint32_t count;   // number of records
+  uint64_t starts;  // offset of index of first record of each bucket
+  uint64_t records; // offset of records, sorted by bucket
+} ht_snapshot_header_t;
+
+// Item stored in the snapshot, its key is stored after all the records
+typedef struct ht_snapshot_record {
+  uint64_t hash;   // full hash of the key
+  uint64_t key;    // offset of the key, 0 when the record was deleted
+  uint32_t length; // length of the key
+  float value;     // value of the item
+} ht_snapshot_record_t;
+
+// Snapshot mapped to memory of the process
+typedef struct ht_snapshot {
+  unsigned char *data;           // start of the mapped file
+  size_t size;                   // size of the mapped file
+  uint32_t mask;                 // number of buckets - 1
+  const uint32_t *starts;        // first record of each bucket and the end
+  ht_snapshot_record_t *records; // records sorted by bucket
+  uint32_t total;                // number of records including deleted ones
+  int count;                     // number of records which weren't deleted
+} ht_snapshot_t;
+
+// Item collected from a table before it's written to the snapshot
+typedef struct ht_snapshot_entry {
+  const char *key; // key of the item
+  uint64_t hash;   // full hash of the key
+  uint32_t length; // length of the key
+  float value;     // value of the item
+} ht_snapshot_entry_t;
+
+ht_snapshot_t *ht_snapshot_map(const char *path);
+void ht_snapshot_unmap(ht_snapshot_t *snapshot);
+void ht_snapshot_prefetch(ht_snapshot_t *snapshot, uint64_t hash);
+ht_snapshot_record_t *ht_snapshot_search(ht_snapshot_t *snapshot,
+                                         const char *key, size_t length,
+                                         uint64_t hash);
+bool ht_snapshot_take(ht_snapshot_t *snapshot, const char *key, size_t length,
+                      uint64_t hash, float *value);
+void ht_snapshot_remove(ht_snapshot_t *snapshot,
+                        ht_snapshot_record_t *record);
+void ht_snapshot_for_each_value(ht_snapshot_t *snapshot,
+                                void (*fn)(float value, void *data),
+                                void *data);
+bool ht_snapshot_next(ht_snapshot_t *snapshot, uint32_t *index,
+                      const char **key, float **value);
+int ht_snapshot_entries(ht_snapshot_t *snapshot,
+                        ht_snapshot_entry_t *entries);
+bool ht_snapshot_write(const char *path, ht_snapshot_entry_t *entries,
+                       int count);
+
+// Implemented by each backend
+ht_snapshot_entry_t *ht_entries(ht_table_t *table, int *count);
+
+#endif
@@ -0,0 +1,1027 @@
+/*
+ * Tabulka s rozptýlenými položkami s otevřeným adresováním
+ *
+ * Alternativní implementace rozhraní ze souboru hashtable.h. Položky jsou
+ * uloženy přímo v poli tabulky a ke každé je v poli ctrl jeden bajt s částí
+ * jejího hashe, takže se při hledání porovnává 16 položek najednou.
+ *
+ * Překládá se místo hashtable.c pomocí `make BACKEND=swiss`.
+ */
+
+#include "hashtable.h"
+#include "hashtable_filter.h"
+#include "hashtable_merge.h"
+#include "hashtable_snapshot.h"
+#include "hashtable_values.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+int HT_SIZE = MAX_HT_SIZE;
+
+// Control byte of slot which was never used
+#define HT_EMPTY ((int8_t)-128)
+// Control byte of slot whose item was deleted
+#define HT_DELETED ((int8_t)-2)
+
+/// @brief Gets tag of the hash stored in control byte of full slot
+/// @param hash hash of the key
+/// @return 7 lowest bits of the hash
+static inline int8_t ht_tag(uint64_t hash) {
+    return hash & 0x7f;
+}
+
+/// @brief Finds slots in group whose control byte equals given byte
+/// @param group control bytes of HT_GROUP slots
+/// @param ctrl control byte to find
+/// @return mask with bit set for each matching slot
+static inline unsigned ht_group_match(const int8_t *group, int8_t ctrl) {
+#ifdef __SSE2__
+    __m128i bytes = _mm_loadu_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(ctrl)));
+#else
+    unsigned mask = 0;
+    for (int i = 0; i < HT_GROUP; ++i)
+        mask |= (unsigned)(group[i] == ctrl) << i;
+    return mask;
+#endif
+}
+
+/// @brief Finds slots in group which are empty or deleted
+/// @param group control bytes of HT_GROUP slots
+/// @return mask with bit set for each free slot
+static inline unsigned ht_group_free(const int8_t *group) {
+#ifdef __SSE2__
+    // Only empty and deleted control bytes have the highest bit set
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+    unsigned mask = 0;
+    for (int i = 0; i < HT_GROUP; ++i)
+        mask |= (unsigned)(group[i] < 0) << i;
+    return mask;
+#endif
+}
+
+/// @brief Finds first free slot for item with given hash
+/// @param table table with at least one free slot
+/// @param hash hash of the key
+/// @return index of the slot
+static int ht_free_slot(ht_table_t *table, uint64_t hash) {
+    int mask = table->size / HT_GROUP - 1;
+    int group = (hash >> 7) & mask;
+    // Triangular probing visits all the groups, because their count is power
+    // of two
+    for (int i = 1;; ++i) {
+        unsigned free = ht_group_free(table->ctrl + group * HT_GROUP);
+        if (free)
+            return group * HT_GROUP + __builtin_ctz(free);
+        group = (group + i) & mask;
+    }
+}
+
+/// @brief Reverses order of bits of the number
+/// @param bits number to reverse
+/// @return the number with the lowest bit moved to the highest one etc.
+static uint32_t ht_reverse(uint32_t bits) {
+    bits = (bits >> 1 & 0x55555555u) | (bits & 0x55555555u) << 1;
+    bits = (bits >> 2 & 0x33333333u) | (bits & 0x33333333u) << 2;
+    bits = (bits >> 4 & 0x0f0f0f0fu) | (bits & 0x0f0f0f0fu) << 4;
+    bits = (bits >> 8 & 0x00ff00ffu) | (bits & 0x00ff00ffu) << 8;
+    return bits >> 16 | bits << 16;
+}
+
+/// @brief Allocates new arrays of given size and moves all items to them
+/// @param table table to be resized
+/// @param size new number of slots, power of two multiple of HT_GROUP
+/// @return true on success, false when allocation failed
+static bool ht_resize(ht_table_t *table, int size) {
+    int8_t *ctrl = malloc(size);
+    ht_item_t *items = malloc(size * sizeof(ht_item_t));
+    if (!ctrl || !items) {
+        free(ctrl);
+        free(items);
+        return false;
+    }
+    memset(ctrl, HT_EMPTY, size);
+
+    int8_t *old_ctrl = table->ctrl;
+    ht_item_t *old_items = table->items;
+    int old_size = table->size;
+    table->ctrl = ctrl;
+    table->items = items;
+    table->size = size;
+    table->deleted = 0;
+    ++table->resizes;
+
+    // Moves the items using their stored hashes, deleted slots are dropped
+    for (int i = 0; i < old_size; ++i) {
+        if (old_ctrl[i] < 0)
+            continue;
+        int slot = ht_free_slot(table, old_items[i].hash);
+        ctrl[slot] = old_ctrl[i];
+        items[slot] = old_items[i];
+    }
+
+    free(old_ctrl);
+    free(old_items);
+    return true;
+}
+
+/*
+ * Inicializace tabulky — zavolá sa před prvním použitím tabulky.
+ */
+void ht_init(ht_table_t *table) {
+    // Slots are allocated on the first insert
+    table->ctrl = NULL;
+    table->items = NULL;
+    table->size = 0;
+    table->count = 0;
+    table->deleted = 0;
+    table->resizes = 0;
+    table->snapshot = NULL;
+    memset(&table->cache, 0, sizeof(table->cache));
+    table->filter = NULL;
+#ifdef HT_COUNTERS
+    memset(&table->counters, 0, sizeof(table->counters));
+#endif
+}
+
+/// @brief Gets key of the item
+/// @param item item to get the key of
+/// @return zero terminated key owned by the item
+char *ht_item_key(ht_item_t *item) {
+    if (item->length < HT_INLINE_KEY)
+        return item->key;
+    // Long key is stored separately, the slot contains pointer to it
+    char *key;
+    memcpy(&key, item->key, sizeof(key));
+    return key;
+}
+
+/// @brief Copies key into the item
+/// @param item item to store the key in, its length must be set
+/// @param key key to be copied
+/// @return true on success, false when allocation failed
+static bool ht_set_key(ht_item_t *item, const char *key) {
+    // Short keys are stored inside the slot
+    if (item->length < HT_INLINE_KEY) {
+        memcpy(item->key, key, item->length);
+        item->key[item->length] = 0;
+        return true;
+    }
+
+    char *copy = malloc(item->length + 1);
+    if (!copy)
+        return false;
+    memcpy(copy, key, item->length);
+    copy[item->length] = 0;
+    memcpy(item->key, &copy, sizeof(copy));
+    return true;
+}
+
+/// @brief Frees key of the item when it's stored outside of its slot
+/// @param item item whose key is freed
+static void ht_free_key(ht_item_t *item) {
+    if (item->length >= HT_INLINE_KEY)
+        free(ht_item_key(item));
+}
+
+/// @brief Searches for slot with given key and its already computed hash
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return index of the slot, -1 when not found
+static int ht_find(ht_table_t *table, const char *key, size_t length,
+                   uint64_t hash) {
+    HT_COUNT(table, searches, 1);
+    // Empty table doesn't have any slots allocated
+    if (!table->items) {
+        HT_COUNT(table, misses, 1);
+        return -1;
+    }
+
+    int mask = table->size / HT_GROUP - 1;
+    int group = (hash >> 7) & mask;
+    int8_t tag = ht_tag(hash);
+    for (int i = 1; i <= mask + 1; ++i) {
+        HT_COUNT(table, probes, 1);
+        int8_t *ctrl = table->ctrl + group * HT_GROUP;
+        // Compares full hashes and keys only in slots with matching tag
+        for (unsigned match = ht_group_match(ctrl, tag); match;
+             match &= match - 1) {
+            int slot = group * HT_GROUP + __builtin_ctz(match);
+            ht_item_t *item = &table->items[slot];
+            if (item->hash == hash && item->length == length &&
+                memcmp(ht_item_key(item), key, length) == 0) {
+                HT_COUNT(table, hits, 1);
+                // Line of the slot is written only when the bit changes
+                if (!item->referenced)
+                    item->referenced = 1;
+                return slot;
+            }
+        }
+        // Item would be inserted into this group if it wasn't full
+        if (ht_group_match(ctrl, HT_EMPTY))
+            break;
+        group = (group + i) & mask;
+    }
+
+    // Item wasn't found
+    HT_COUNT(table, misses, 1);
+    return -1;
+}
+
+/// @brief Gets number of bytes used by item with key of given length
+/// @param length length of the key
+/// @return size of the slot, its control byte and of the key when it's
+///         stored separately
+static size_t ht_item_bytes(size_t length) {
+    return sizeof(ht_item_t) + 1 + (length >= HT_INLINE_KEY ? length + 1 : 0);
+}
+
+/// @brief Adds all keys of the table to the filter
+/// @param table table whose keys are added
+/// @param filter filter to add to
+static void ht_filter_table(ht_table_t *table, ht_filter_t *filter) {
+    for (int i = 0; i < table->size; ++i) {
+        if (table->ctrl[i] >= 0)
+            ht_filter_add(filter, table->items[i].hash);
+    }
+    if (table->snapshot)
+        ht_filter_add_snapshot(filter, table->snapshot);
+}
+
+/// @brief Gets number of keys of the table including the mapped ones
+/// @param table table to count
+/// @return number of the keys
+static int ht_keys(ht_table_t *table) {
+    return table->count + (table->snapshot ? table->snapshot->count : 0);
+}
+
+/// @brief Builds the filter again when it's too full or has too many keys
+///        which were deleted
+/// @param table table whose filter is checked
+static void ht_filter_refresh(ht_table_t *table) {
+    if (!table->filter || !ht_filter_stale(table->filter, ht_keys(table)))
+        return;
+    // Stale filter is still correct, so it's kept when allocation fails
+    ht_filter_t *filter = ht_filter_resize(table->filter, ht_keys(table));
+    if (!filter)
+        return;
+    ht_filter_table(table, filter);
+    table->filter = filter;
+}
+
+/// @brief Checks the key by the filter of the table
+/// @param table table whose filter is used
+/// @param hash hash of the key
+/// @return true when the key surely isn't in the table, else false
+static bool ht_rejected(ht_table_t *table, uint64_t hash) {
+    if (ht_filter_pass(table->filter, hash))
+        return false;
+    HT_COUNT(table, searches, 1);
+    HT_COUNT(table, misses, 1);
+    return true;
+}
+
+/// @brief Frees item in given slot and marks the slot as free
+/// @param table table the item belongs to
+/// @param slot index of the slot
+static void ht_remove(ht_table_t *table, int slot) {
+    table->cache.bytes -= ht_item_bytes(table->items[slot].length);
+    ht_free_key(&table->items[slot]);
+
+    // Searches never continue past group with empty slot, so the slot can be
+    // empty again, otherwise it has to stay in the probe sequences
+    int8_t *group = table->ctrl + slot / HT_GROUP * HT_GROUP;
+    if (ht_group_match(group, HT_EMPTY)) {
+        table->ctrl[slot] = HT_EMPTY;
+    } else {
+        table->ctrl[slot] = HT_DELETED;
+        ++table->deleted;
+    }
+    --table->count;
+    ht_filter_remove(table->filter);
+    ht_filter_refresh(table);
+}
+
+/// @brief Evicts one item which wasn't found since the last eviction pass
+///
+/// Uses CLOCK policy. The hand goes through the slots, clears reference bits
+/// of found items and evicts the first item whose bit is already clear.
+///
+/// @param table table to evict from, must contain an item
+static void ht_evict(ht_table_t *table) {
+    for (;; table->cache.hand = (table->cache.hand + 1) % table->size) {
+        int slot = table->cache.hand % table->size;
+        if (table->ctrl[slot] < 0)
+            continue;
+        if (table->items[slot].referenced) {
+            table->items[slot].referenced = 0;
+            continue;
+        }
+        ht_remove(table, slot);
+        ++table->cache.evictions;
+        return;
+    }
+}
+
+/// @brief Checks whether the table is over its budget
+/// @param table table to check
+/// @param items number of items to be added
+/// @param bytes number of bytes to be added
+/// @return true when an item has to be evicted, else false
+static bool ht_over_budget(ht_table_t *table, int items, size_t bytes) {
+    ht_cache_t *cache = &table->cache;
+    return table->count > 0 &&
+           ((cache->max_items && table->count + items > cache->max_items) ||
+            (cache->max_bytes && cache->bytes + bytes > cache->max_bytes));
+}
+
+/// @brief Adds new item to the table
+/// @param table table to add to
+/// @param key key of the item, it's copied
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param value value of the item
+/// @return index of the slot of the item, -1 when allocation failed
+static int ht_add(ht_table_t *table, const char *key, size_t length,
+                  uint64_t hash, float value) {
+    // Allocates slots on the first insert, size is rounded up to power of
+    // two multiple of HT_GROUP
+    if (!table->items) {
+        int size = HT_GROUP;
+        while (size < HT_SIZE)
+            size *= 2;
+        if (!ht_resize(table, size))
+            return -1;
+    }
+    // Cache makes room for the new item instead of growing
+    while (ht_over_budget(table, 1, ht_item_bytes(length)))
+        ht_evict(table);
+
+    // Keeps at most 7/8 of slots used, deleted slots are just dropped when
+    // there are many of them, otherwise the table grows
+    if ((table->count + table->deleted + 1) * 8 > table->size * 7) {
+        int size = table->count * 16 > table->size * 7 ? table->size * 2
+                                                        : table->size;
+        if (!ht_resize(table, size))
+            return -1;
+    }
+
+    // Key is copied, so the caller doesn't have to keep it, short keys
+    // don't need any allocation
+    int slot = ht_free_slot(table, hash);
+    table->items[slot].length = length;
+    if (!ht_set_key(&table->items[slot], key))
+        return -1;
+    if (table->ctrl[slot] == HT_DELETED)
+        --table->deleted;
+    table->ctrl[slot] = ht_tag(hash);
+    table->items[slot].value = value;
+    table->items[slot].hash = hash;
+    table->items[slot].referenced = 0;
+    table->cache.bytes += ht_item_bytes(length);
+    ++table->count;
+    if (table->filter) {
+        ht_filter_add(table->filter, hash);
+        ht_filter_refresh(table);
+    }
+    return slot;
+}
+
+/// @brief Searches for slot whose key passed the filter, moves item of
+///        mapped snapshot to the table
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return index of the slot, -1 when not found
+static int ht_lookup(ht_table_t *table, const char *key, size_t length,
+                     uint64_t hash) {
+    int slot = ht_find(table, key, length, hash);
+    if (slot >= 0)
+        return slot;
+
+    // Item of mapped snapshot moves to the table, so the returned item can
+    // be changed and kept like any other. The record is removed only after
+    // the item was added, so failed allocation doesn't lose it.
+    ht_snapshot_record_t *record =
+        table->snapshot ? ht_snapshot_search(table->snapshot, key, length, hash)
+                        : NULL;
+    if (record) {
+        slot = ht_add(table, key, length, hash, record->value);
+        if (slot >= 0)
+            ht_snapshot_remove(table->snapshot, record);
+        return slot;
+    }
+    ht_filter_missed(table->filter);
+    return -1;
+}
+
+/*
+ * Vyhledání prvku v tabulce.
+ *
+ * V případě úspěchu vrací ukazatel na nalezený prvek; v opačném případě vrací
+ * hodnotu NULL.
+ */
+ht_item_t *ht_search(ht_table_t *table, char *key) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    return ht_search_hashed(table, key, length, hash);
+}
+
+/// @brief Searches for item with key of given length
+///
+/// The key is hashed and compared in place, it isn't copied, so it can be
+/// a slice of a bigger buffer.
+///
+/// @param table table to search in
+/// @param key key of the item, doesn't have to be zero terminated
+/// @param length length of the key
+/// @return found item, NULL when not found
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length) {
+    if (length >= HT_MAX_KEY)
+        return NULL;
+    return ht_search_hashed(table, key, length, ht_hash_n(key, length));
+}
+
+/// @brief Searches for item with given key and its already computed hash
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return found item, NULL when not found
+ht_item_t *ht_search_hashed(ht_table_t *table, const char *key, size_t length,
+                            uint64_t hash) {
+    if (length >= HT_MAX_KEY || ht_rejected(table, hash))
+        return NULL;
+    int slot = ht_lookup(table, key, length, hash);
+    return slot < 0 ? NULL : &table->items[slot];
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahraďte jeho hodnotu.
+ */
+void ht_insert(ht_table_t *table, char *key, float value) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_insert_hashed(table, key, length, hash, value);
+}
+
+/// @brief Inserts item with key of given length
+/// @param table table to insert to
+/// @param key key of the item, doesn't have to be zero terminated, the copy
+///        owned by the table is
+/// @param length length of the key
+/// @param value value of the item, replaces value of existing item
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value) {
+    if (length >= HT_MAX_KEY)
+        return;
+    ht_insert_hashed(table, key, length, ht_hash_n(key, length), value);
+}
+
+/// @brief Inserts item with given key and its already computed hash
+/// @param table table to insert to
+/// @param key key of the item, it's copied
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param value value of the item, replaces value of existing item
+void ht_insert_hashed(ht_table_t *table, const char *key, size_t length,
+                      uint64_t hash, float value) {
+    if (length >= HT_MAX_KEY)
+        return;
+    if (!ht_rejected(table, hash)) {
+        // Searches for key in table, changes the value to new value if exists
+        int slot = ht_find(table, key, length, hash);
+        if (slot >= 0) {
+            table->items[slot].value = value;
+            return;
+        }
+        // Item of mapped snapshot is replaced by the new one, it's removed
+        // only when the new one was added
+        ht_snapshot_record_t *record =
+            table->snapshot
+                ? ht_snapshot_search(table->snapshot, key, length, hash)
+                : NULL;
+        if (record) {
+            if (ht_add(table, key, length, hash, value) >= 0)
+                ht_snapshot_remove(table->snapshot, record);
+            return;
+        }
+        ht_filter_missed(table->filter);
+    }
+
+    ht_add(table, key, length, hash, value);
+}
+
+/// @brief Gets value of the key, inserts the key with value 0 when it's
+///        missing
+///
+/// The key is hashed once and its list (or probe sequence) is walked once,
+/// unlike ht_get followed by ht_insert.
+///
+/// @param table table to search in
+/// @param key key of the item, it's copied when inserted
+/// @param inserted set to whether the key was inserted, may be NULL
+/// @return pointer to value of the item, valid until the table is changed,
+///         NULL when allocation failed
+float *ht_find_or_insert(ht_table_t *table, char *key, bool *inserted) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    return ht_find_or_insert_hashed(table, key, length, hash, inserted);
+}
+
+/// @brief Gets value of the key and its already computed hash, inserts the
+///        key with value 0 when it's missing
+/// @param table table to search in
+/// @param key key of the item, it's copied when inserted
+/// @param length length of the key
+/// @param hash hash of the key
+/// @param inserted set to whether the key was inserted, may be NULL
+/// @return pointer to value of the item, NULL when allocation failed or the
+///         key is too long
+float *ht_find_or_insert_hashed(ht_table_t *table, const char *key,
+                                size_t length, uint64_t hash, bool *inserted) {
+    if (length >= HT_MAX_KEY) {
+        if (inserted)
+            *inserted = false;
+        return NULL;
+    }
+    int slot = ht_rejected(table, hash) ? -1
+                                        : ht_lookup(table, key, length, hash);
+    bool added = false;
+    if (slot < 0) {
+        slot = ht_add(table, key, length, hash, 0);
+        added = slot >= 0;
+    }
+    if (inserted)
+        *inserted = added;
+    return slot < 0 ? NULL : &table->items[slot].value;
+}
+
+/// @brief Adds to the value of the key, like ht_get followed by ht_insert
+///        but with one hash and one search
+/// @param table table containing the item
+/// @param key key of the item, inserted with value 0 when it doesn't exist
+/// @param delta number added to the value
+/// @return new value of the item, NaN when allocation failed
+float ht_accumulate(ht_table_t *table, char *key, float delta) {
+    float *value = ht_find_or_insert(table, key, NULL);
+    return value ? *value += delta : NAN;
+}
+
+/*
+ * Získání hodnoty z tabulky.
+ *
+ * V případě úspěchu vrací funkce ukazatel na hodnotu prvku, v opačném
+ * případě hodnotu NULL.
+ */
+float *ht_get(ht_table_t *table, char *key) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    return ht_get_hashed(table, key, length, hash);
+}
+
+/// @brief Gets value of the key and its already computed hash
+/// @param table table to search in
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+/// @return pointer to the value, NULL when not found
+float *ht_get_hashed(ht_table_t *table, const char *key, size_t length,
+                     uint64_t hash) {
+    if (length >= HT_MAX_KEY || ht_rejected(table, hash)) {
+        ++table->cache.misses;
+        return NULL;
+    }
+    // Values of mapped snapshot are used in place, the item isn't moved
+    if (table->snapshot) {
+        ht_snapshot_record_t *record =
+            ht_snapshot_search(table->snapshot, key, length, hash);
+        if (record) {
+            ++table->cache.hits;
+            return &record->value;
+        }
+    }
+
+    // Snapshot was searched already, only the slots are left
+    int slot = ht_find(table, key, length, hash);
+    if (slot >= 0) {
+        ++table->cache.hits;
+        return &table->items[slot].value;
+    }
+    ht_filter_missed(table->filter);
+    ++table->cache.misses;
+    return NULL;
+}
+
+/// @brief Gets value of the key of given length
+/// @param table table to search in
+/// @param key key of the item, doesn't have to be zero terminated
+/// @param length length of the key
+/// @return pointer to the value, NULL when not found
+float *ht_get_n(ht_table_t *table, const char *key, size_t length) {
+    if (length >= HT_MAX_KEY)
+        return NULL;
+    return ht_get_hashed(table, key, length, ht_hash_n(key, length));
+}
+
+/// @brief Gets values of many keys at once
+///
+/// Keys are processed in batches of HT_BATCH. All the keys of a batch are
+/// hashed and their first groups prefetched before any of them is searched,
+/// so waiting for memory overlaps across the keys. Keys rejected by the
+/// filter aren't searched at all.
+///
+/// @param table table to search in
+/// @param keys keys to get the values of
+/// @param n number of keys
+/// @param values set to pointer to value of each key, NULL when not found
+void ht_get_many(ht_table_t *table, char *keys[], int n, float *values[]) {
+    for (int start = 0; start < n; start += HT_BATCH) {
+        int count = n - start < HT_BATCH ? n - start : HT_BATCH;
+        uint64_t hashes[HT_BATCH];
+        size_t lengths[HT_BATCH];
+        bool passed[HT_BATCH];
+
+        // Hashes the keys and prefetches their control bytes and slots
+        for (int i = 0; i < count; ++i) {
+            hashes[i] = ht_hash(keys[start + i], &lengths[i]);
+            passed[i] = !ht_rejected(table, hashes[i]);
+            if (!passed[i])
+                continue;
+            if (table->snapshot)
+                ht_snapshot_prefetch(table->snapshot, hashes[i]);
+            if (!table->items)
+                continue;
+            int group = (hashes[i] >> 7) & (table->size / HT_GROUP - 1);
+            __builtin_prefetch(table->ctrl + group * HT_GROUP);
+            __builtin_prefetch(table->items + group * HT_GROUP);
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (!passed[i]) {
+                values[start + i] = NULL;
+                ++table->cache.misses;
+                continue;
+            }
+            // Values of mapped snapshot are used in place
+            ht_snapshot_record_t *record =
+                table->snapshot
+                    ? ht_snapshot_search(table->snapshot, keys[start + i],
+                                         lengths[i], hashes[i])
+                    : NULL;
+            if (record) {
+                values[start + i] = &record->value;
+                ++table->cache.hits;
+                continue;
+            }
+            int slot = ht_find(table, keys[start + i], lengths[i], hashes[i]);
+            values[start + i] = slot < 0 ? NULL : &table->items[slot].value;
+            if (slot < 0)
+                ht_filter_missed(table->filter);
+            table->cache.hits += slot >= 0;
+            table->cache.misses += slot < 0;
+        }
+    }
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Pokud prvek neexistuje, funkce nedělá nic.
+ */
+void ht_delete(ht_table_t *table, char *key) {
+    size_t length;
+    uint64_t hash = ht_hash(key, &length);
+    ht_delete_hashed(table, key, length, hash);
+}
+
+/// @brief Deletes item with key of given length
+/// @param table table to delete from
+/// @param key key of the item, doesn't have to be zero terminated
+/// @param length length of the key
+void ht_delete_n(ht_table_t *table, const char *key, size_t length) {
+    if (length >= HT_MAX_KEY)
+        return;
+    ht_delete_hashed(table, key, length, ht_hash_n(key, length));
+}
+
+/// @brief Deletes item with given key and its already computed hash
+/// @param table table to delete from
+/// @param key key of the item
+/// @param length length of the key
+/// @param hash hash of the key
+void ht_delete_hashed(ht_table_t *table, const char *key, size_t length,
+                      uint64_t hash) {
+    if (length >= HT_MAX_KEY || !ht_filter_pass(table->filter, hash))
+        return;
+    // Item of mapped snapshot is removed from the mapping only
+    if (table->snapshot &&
+        ht_snapshot_take(table->snapshot, key, length, hash, NULL)) {
+        ht_filter_remove(table->filter);
+        ht_filter_refresh(table);
+        return;
+    }
+    int slot = ht_find(table, key, length, hash);
+    if (slot >= 0)
+        ht_remove(table, slot);
+    else
+        ht_filter_missed(table->filter);
+}
+
+/*
+ * Smazání všech prvků z tabulky.
+ *
+ * Funkce korektně uvolní všechny alokované zdroje a uvede tabulku do stavu po
+ * inicializaci.
+ */
+void ht_delete_all(ht_table_t *table) {
+    for (int i = 0; i < table->size; ++i) {
+        if (table->ctrl[i] >= 0)
+            ht_free_key(&table->items[i]);
+    }
+    free(table->ctrl);
+    free(table->items);
+    ht_snapshot_unmap(table->snapshot);
+    ht_filter_free(table->filter);
+    ht_init(table);
+}
+
+/// @brief Gets statistics of the table
+///
+/// Length of probe sequence of an item is number of groups checked before
+/// the item is found.
+///
+/// @param table table to get the statistics of
+/// @param stats set to the statistics
+void ht_stats(ht_table_t *table, ht_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->count = table->count;
+    stats->size = table->size;
+    if (stats->size)
+        stats->load = (float)stats->count / stats->size;
+    // Items of mapped snapshot aren't in the slots
+    if (table->snapshot)
+        stats->count += table->snapshot->count;
+    stats->memory = table->size * (1 + sizeof(ht_item_t));
+
+    int mask = table->size / HT_GROUP - 1;
+    for (int i = 0; i < table->size; ++i) {
+        if (table->ctrl[i] < 0)
+            continue;
+        if (table->items[i].length >= HT_INLINE_KEY)
+            stats->memory += table->items[i].length + 1;
+
+        int group = (table->items[i].hash >> 7) & mask;
+        int length = 1;
+        while (group != i / HT_GROUP)
+            group = (group + length++) & mask;
+        ++stats->histogram[length < HT_HISTOGRAM ? length : HT_HISTOGRAM - 1];
+        if (length > stats->max_length)
+            stats->max_length = length;
+    }
+    stats->cache = table->cache;
+    stats->memory += ht_filter_stats(table->filter, &stats->filter);
+#ifdef HT_COUNTERS
+    stats->counters = table->counters;
+#endif
+}
+
+/// @brief Limits the table to given budget, so it can be used as a cache
+///
+/// When the budget is full, insert of a new key evicts items which weren't
+/// found recently (CLOCK policy). A found item only gets its reference bit
+/// set, nothing is moved. The budget holds until ht_delete_all.
+///
+/// @param table table to limit, items over the budget are evicted at once
+/// @param max_items max number of items, 0 when not limited
+/// @param max_bytes max bytes of items and their keys, 0 when not limited
+void ht_set_budget(ht_table_t *table, int max_items, size_t max_bytes) {
+    table->cache.max_items = max_items;
+    table->cache.max_bytes = max_bytes;
+    while (ht_over_budget(table, 0, 0))
+        ht_evict(table);
+}
+
+/// @brief Enables filter of keys which aren't in the table
+///
+/// Each search first checks the key in blocked Bloom filter, which fits
+/// one block of bits of the key in a cache line. Most of the keys which
+/// aren't in the table are rejected without probing their groups. The
+/// filter is rebuilt when the table outgrows it or after many deletes, it's
+/// disabled by ht_delete_all.
+///
+/// @param table table to filter, its current keys are added
+/// @param fp_rate wanted false positive rate, 0 disables the filter
+/// @return false when the rate isn't in [0, 1) or allocation failed and the
+///         filter is disabled, else true
+bool ht_set_filter(ht_table_t *table, double fp_rate) {
+    ht_filter_free(table->filter);
+    table->filter = NULL;
+    if (fp_rate == 0)
+        return true;
+    if (!(fp_rate > 0 && fp_rate < 1))
+        return false;
+
+    ht_filter_t *filter = ht_filter_create(fp_rate, ht_keys(table));
+    if (!filter)
+        return false;
+    ht_filter_table(table, filter);
+    table->filter = filter;
+    return true;
+}
+
+/// @brief Merges items stored in one table into another, items of its
+///        mapped snapshot are merged by ht_merge
+/// @param dst table to merge into
+/// @param src table to merge, it isn't changed, mustn't be dst
+/// @param combine combines value in dst with the value in src, NULL when
+///        the value in src replaces it
+void ht_merge_items(ht_table_t *dst, ht_table_t *src,
+                    float (*combine)(float dst, float src)) {
+    for (int i = 0; i < src->size; ++i) {
+        if (src->ctrl[i] < 0)
+            continue;
+        ht_item_t *item = &src->items[i];
+        ht_merge_value(dst, ht_item_key(item), item->length, item->hash, item->value,
+                       combine);
+    }
+}
+
+/// @brief Collects all items of the table including the mapped ones
+/// @param table table to collect from
+/// @param count set to number of the collected items
+/// @return items whose keys are owned by the table, to be freed by caller,
+///         NULL when allocation failed
+ht_snapshot_entry_t *ht_entries(ht_table_t *table, int *count) {
+    int mapped = table->snapshot ? table->snapshot->count : 0;
+    ht_snapshot_entry_t *entries =
+        malloc((table->count + mapped + 1) * sizeof(ht_snapshot_entry_t));
+    if (!entries)
+        return NULL;
+
+    *count = table->snapshot ? ht_snapshot_entries(table->snapshot, entries)
+                             : 0;
+    for (int i = 0; i < table->size; ++i) {
+        if (table->ctrl[i] < 0)
+            continue;
+        entries[*count].key = table->items[i].key;
+        entries[*count].hash = table->items[i].hash;
+        entries[*count].length = table->items[i].length;
+        entries[*count].value = table->items[i].value;
+        ++*count;
+    }
+    return entries;
+}
+
+/// @brief Calls function with each value of the table
+/// @param table table to go through
+/// @param fn function to call, NaN values are skipped
+/// @param data passed to the function
+void ht_for_each_value(ht_table_t *table, void (*fn)(float value, void *data),
+                       void *data) {
+    // Slots are read sequentially, control bytes tell which are used
+    for (int i = 0; i < table->size; ++i) {
+        if (table->ctrl[i] >= 0 && !isnan(table->items[i].value))
+            fn(table->items[i].value, data);
+    }
+    if (table->snapshot)
+        ht_snapshot_for_each_value(table->snapshot, fn, data);
+}
+
+/// @brief Aggregates all values of the table in one pass
+/// @param table table to aggregate
+/// @param aggregate set to sum, min, max and count of the values
+void ht_aggregate(ht_table_t *table, ht_aggregate_t *aggregate) {
+    ht_aggregate_init(aggregate);
+    ht_for_each_value(table, ht_aggregate_value, aggregate);
+}
+
+/// @brief Gets next home group in reversed bit order
+///
+/// Groups of table twice as big are visited in the same order, each group
+/// followed by the one it's split to, so iteration can continue after the
+/// table grows (the same cursor as Redis SCAN uses).
+///
+/// @param home current home group
+/// @param mask number of groups - 1
+/// @return next home group, 0 after the last one
+static uint32_t ht_next_home(uint32_t home, uint32_t mask) {
+    // Bits above the mask are set, so the increment carries through them
+    home |= ~mask;
+    home = ht_reverse(home);
+    ++home;
+    return ht_reverse(home);
+}
+
+/// @brief Starts iteration over all items of the table
+///
+/// Items are returned by their home groups. Items deleted before they're
+/// reached aren't returned, items inserted during the iteration may be
+/// returned or not. When the table is resized during the iteration, items
+/// of the current home group may be returned again, no item is skipped.
+/// Item moved from mapped snapshot by ht_search may be returned twice.
+///
+/// @param table table to iterate, mustn't be cleared by ht_delete_all
+/// @param iter set to position before the first item
+void ht_iter_begin(ht_table_t *table, ht_iter_t *iter) {
+    iter->table = table;
+    iter->record = 0;
+    iter->home = 0;
+    iter->group = 0;
+    iter->step = 0;
+    iter->slot = 0;
+    iter->resizes = table->resizes;
+    iter->done = false;
+}
+
+/// @brief Gets next item of the iteration
+/// @param iter position of the iteration
+/// @param key set to key of the item, owned by the table
+/// @param value set to pointer to value of the item
+/// @return false when there are no more items, else true
+bool ht_iter_next(ht_iter_t *iter, const char **key, float **value) {
+    ht_table_t *table = iter->table;
+    // Items of mapped snapshot go first, so the ones moved before they're
+    // reached aren't skipped, the ones moved after that are returned again
+    // when their slot is reached
+    if (table->snapshot &&
+        ht_snapshot_next(table->snapshot, &iter->record, key, value))
+        return true;
+    if (iter->done || !table->items)
+        return false;
+
+    // Items moved, probing of the home group starts again
+    uint32_t mask = table->size / HT_GROUP - 1;
+    if (iter->resizes != table->resizes) {
+        iter->resizes = table->resizes;
+        iter->home &= mask;
+        iter->group = iter->home;
+        iter->step = 0;
+        iter->slot = 0;
+    }
+
+    for (;;) {
+        // Items of the home group are in its probe sequence
+        int8_t *ctrl = table->ctrl + iter->group * HT_GROUP;
+        while (iter->slot < HT_GROUP) {
+            int slot = iter->group * HT_GROUP + iter->slot++;
+            if (table->ctrl[slot] < 0 ||
+                ((table->items[slot].hash >> 7) & mask) != iter->home)
+                continue;
+            *key = ht_item_key(&table->items[slot]);
+            *value = &table->items[slot].value;
+            return true;
+        }
+
+        // Probe sequence ends at group with empty slot, like in ht_find
+        if (!ht_group_match(ctrl, HT_EMPTY) && (uint32_t)iter->step < mask) {
+            ++iter->step;
+            iter->group = (iter->group + iter->step) & mask;
+            iter->slot = 0;
+            continue;
+        }
+
+        iter->home = ht_next_home(iter->home, mask);
+        if (iter->home == 0) {
+            iter->done = true;
+            return false;
+        }
+        iter->group = iter->home;
+        iter->step = 0;
+        iter->slot = 0;
+    }
+}
+
+/// @brief Copies keys and values of the table into arrays
+/// @param table table to export
+/// @param keys filled with keys owned by the table, valid until the table is
+///        changed, may be NULL
+/// @param values filled with the values, may be NULL
+/// @param n capacity of the arrays
+/// @return number of exported items, at most n
+int ht_export(ht_table_t *table, const char *keys[], float values[], int n) {
+    ht_iter_t iter;
+    ht_iter_begin(table, &iter);
+    const char *key;
+    float *value;
+    int count = 0;
+    while (count < n && ht_iter_next(&iter, &key, &value)) {
+        if (keys)
+            keys[count] = key;
+        if (values)
+            values[count] = *value;
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,12 @@
+/*
+ * Tabulky s rozptýlenými položkami specializované pro typ klíče
+ *
+ * Implementace tabulek deklarovaných v hashtable_typed.h. Celočíselné klíče
+ * se hashují jedním násobením a porovnávají přímo, bez převodu na řetězec.
+ */
+
+#include "hashtable_typed.h"
+
+HTDEF(int, float, int)
+HTDEF(uint64_t, float, u64)
+HTDEF(const char *, float, str)
@@ -0,0 +1,232 @@
+/*
+ * Hlavičkový soubor pro tabulky s rozptýlenými položkami specializované
+ * pro typ klíče a hodnoty.
+ */
+
+#ifndef IAL_HASHTABLE_TYPED_H
+#define IAL_HASHTABLE_TYPED_H
+
+#include "hashtable.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Control byte of slot which was never used
+#define HT_TYPED_EMPTY ((int8_t)-128)
+// Control byte of slot whose item was deleted
+#define HT_TYPED_DELETED ((int8_t)-2)
+// Number of slots allocated on the first insert
+#define HT_TYPED_MIN 16
+
+/// @brief Gets tag of the hash stored in control byte of full slot
+/// @param hash hash of the key
+/// @return top 7 bits of the hash, slot index uses the low ones
+static inline int8_t ht_typed_tag(uint64_t hash) {
+  return (int8_t)(hash >> 57);
+}
+
+/// @brief Hashes integer key by one multiplication
+/// @param key key to hash, int keys are converted to it
+/// @return hash of the key, its high bits are folded into the low ones
+static inline uint64_t ht_hash_integer(uint64_t key) {
+  uint64_t hash = (key ^ HT_SEED) * 0x9e3779b97f4a7c15ull;
+  return hash ^ hash >> 32;
+}
+
+/// @brief Hashes zero terminated key like the string table does
+/// @param key key to hash
+/// @return hash of the key
+static inline uint64_t ht_hash_string(const char *key) {
+  return ht_hash(key, NULL);
+}
+
+// Compares keys which can be compared directly, like integers
+#define HT_EQUALS(a, b) ((a) == (b))
+
+/// @brief Compares zero terminated keys
+/// @param a first key
+/// @param b second key
+/// @return true when the keys are equal, else false
+static inline bool ht_equals_string(const char *a, const char *b) {
+  return strcmp(a, b) == 0;
+}
+
+/*
+ * Makro generující deklarace tabulky s klíči typu K a hodnotami typu V
+ * s názvovým infixem NAME. Klíče se hashují funkcí (nebo makrem)
+ * HASH(key) vracející uint64_t a porovnávají pomocí EQ(a, b). Klíče
+ * i hodnoty jsou uloženy přímo v poli tabulky, klíče se nekopírují
+ * (ukazatele na řetězce musí zůstat platné, dokud jsou v tabulce).
+ * Pro NAME="int" pracující s typy K="int", V="float":
+ *   Datové typy ht_int_item_t (key, value) a ht_int_t
+ *   Funkce void ht_int_init(ht_int_t *table)
+ *          ht_int_item_t *ht_int_search(ht_int_t *table, int key)
+ *          void ht_int_insert(ht_int_t *table, int key, float value)
+ *          float *ht_int_get(ht_int_t *table, int key)
+ *          void ht_int_delete(ht_int_t *table, int key)
+ *          void ht_int_delete_all(ht_int_t *table)
+ * Implementaci generuje HTDEF se stejnými parametry K, V a NAME.
+ */
+#define HTDEC(K, V, NAME, HASH, EQ)                                            \
+  typedef struct {                                                             \
+    K key;                                                                     \
+    V value;                                                                   \
+  } ht_##NAME##_item_t;                                                        \
+                                                                               \
+  typedef struct {                                                             \
+    int8_t *ctrl;               /* tag of each slot, empty or deleted */       \
+    ht_##NAME##_item_t *items;  /* slots, NULL until first insert */           \
+    int size;                   /* number of slots, power of two */            \
+    int count;                  /* number of items in the table */             \
+    int deleted;                /* number of slots marked as deleted */        \
+  } ht_##NAME##_t;                                                             \
+                                                                               \
+  static inline uint64_t ht_##NAME##_hash(K key) { return HASH(key); }         \
+  static inline bool ht_##NAME##_equals(K a, K b) { return EQ(a, b); }         \
+                                                                               \
+  void ht_##NAME##_init(ht_##NAME##_t *table);                                 \
+  ht_##NAME##_item_t *ht_##NAME##_search(ht_##NAME##_t *table, K key);         \
+  void ht_##NAME##_insert(ht_##NAME##_t *table, K key, V value);               \
+  V *ht_##NAME##_get(ht_##NAME##_t *table, K key);                             \
+  void ht_##NAME##_delete(ht_##NAME##_t *table, K key);                        \
+  void ht_##NAME##_delete_all(ht_##NAME##_t *table);
+
+/*
+ * Makro generující implementaci funkcí tabulky deklarované pomocí HTDEC.
+ * Tabulka používá otevřené adresování s lineárním prohledáváním, v poli
+ * ctrl je ke každé položce 7 bitů jejího hashe, takže se klíče porovnávají
+ * jen u položek se shodnou značkou. Nejvýše 7/8 položek je obsazeno.
+ */
+#define HTDEF(K, V, NAME)                                                      \
+  void ht_##NAME##_init(ht_##NAME##_t *table) {                                \
+    table->ctrl = NULL;                                                        \
+    table->items = NULL;                                                       \
+    table->size = 0;                                                           \
+    table->count = 0;                                                          \
+    table->deleted = 0;                                                        \
+  }                                                                            \
+                                                                               \
+  static int ht_##NAME##_find(ht_##NAME##_t *table, K key, uint64_t hash) {    \
+    if (!table->items) {                                                       \
+      return -1;                                                               \
+    }                                                                          \
+    int mask = table->size - 1;                                                \
+    int8_t tag = ht_typed_tag(hash);                                           \
+    /* There's always an empty slot, which ends the search */                  \
+    for (int slot = hash & mask;; slot = (slot + 1) & mask) {                  \
+      if (table->ctrl[slot] == HT_TYPED_EMPTY) {                               \
+        return -1;                                                             \
+      }                                                                        \
+      if (table->ctrl[slot] == tag &&                                          \
+          ht_##NAME##_equals(table->items[slot].key, key)) {                   \
+        return slot;                                                           \
+      }                                                                        \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static int ht_##NAME##_free_slot(ht_##NAME##_t *table, uint64_t hash) {      \
+    int mask = table->size - 1;                                                \
+    int slot = hash & mask;                                                    \
+    while (table->ctrl[slot] >= 0) {                                           \
+      slot = (slot + 1) & mask;                                                \
+    }                                                                          \
+    return slot;                                                               \
+  }                                                                            \
+                                                                               \
+  static bool ht_##NAME##_resize(ht_##NAME##_t *table, int size) {             \
+    int8_t *ctrl = malloc(size);                                               \
+    ht_##NAME##_item_t *items = malloc(size * sizeof(ht_##NAME##_item_t));     \
+    if (!ctrl || !items) {                                                     \
+      free(ctrl);                                                              \
+      free(items);                                                             \
+      return false;                                                            \
+    }                                                                          \
+    memset(ctrl, HT_TYPED_EMPTY, size);                                        \
+                                                                               \
+    /* Hashes aren't stored, they're computed again for each key */            \
+    ht_##NAME##_t resized = {ctrl, items, size, 0, 0};                         \
+    for (int i = 0; i < table->size; ++i) {                                    \
+      if (table->ctrl[i] < 0) {                                                \
+        continue;                                                              \
+      }                                                                        \
+      uint64_t hash = ht_##NAME##_hash(table->items[i].key);                   \
+      int slot = ht_##NAME##_free_slot(&resized, hash);                        \
+      ctrl[slot] = ht_typed_tag(hash);                                         \
+      items[slot] = table->items[i];                                           \
+      ++resized.count;                                                         \
+    }                                                                          \
+    free(table->ctrl);                                                         \
+    free(table->items);                                                        \
+    *table = resized;                                                          \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  ht_##NAME##_item_t *ht_##NAME##_search(ht_##NAME##_t *table, K key) {        \
+    int slot = ht_##NAME##_find(table, key, ht_##NAME##_hash(key));            \
+    return slot < 0 ? NULL : &table->items[slot];                              \
+  }                                                                            \
+                                                                               \
+  void ht_##NAME##_insert(ht_##NAME##_t *table, K key, V value) {              \
+    uint64_t hash = ht_##NAME##_hash(key);                                     \
+    int slot = ht_##NAME##_find(table, key, hash);                             \
+    if (slot >= 0) {                                                           \
+      table->items[slot].value = value;                                        \
+      return;                                                                  \
+    }                                                                          \
+                                                                               \
+    /* Deleted slots are just dropped when there are many of them */           \
+    if (!table->items ||                                                       \
+        (table->count + table->deleted + 1) * 8 > table->size * 7) {           \
+      int size = table->size * 2;                                              \
+      if (!table->items) {                                                     \
+        size = HT_TYPED_MIN;                                                   \
+      } else if (table->count * 16 <= table->size * 7) {                       \
+        size = table->size;                                                    \
+      }                                                                        \
+      if (!ht_##NAME##_resize(table, size)) {                                  \
+        return;                                                                \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    slot = ht_##NAME##_free_slot(table, hash);                                 \
+    if (table->ctrl[slot] == HT_TYPED_DELETED) {                               \
+      --table->deleted;                                                        \
+    }                                                                          \
+    table->ctrl[slot] = ht_typed_tag(hash);                                    \
+    table->items[slot].key = key;                                              \
+    table->items[slot].value = value;                                          \
+    ++table->count;                                                            \
+  }                                                                            \
+                                                                               \
+  V *ht_##NAME##_get(ht_##NAME##_t *table, K key) {                            \
+    int slot = ht_##NAME##_find(table, key, ht_##NAME##_hash(key));            \
+    return slot < 0 ? NULL : &table->items[slot].value;                        \
+  }                                                                            \
+                                                                               \
+  void ht_##NAME##_delete(ht_##NAME##_t *table, K key) {                       \
+    int slot = ht_##NAME##_find(table, key, ht_##NAME##_hash(key));            \
+    if (slot < 0) {                                                            \
+      return;                                                                  \
+    }                                                                          \
+    /* Searches stop at empty slot, so the slot can be empty again when */     \
+    /* the next one is, otherwise it has to stay in the probe sequence */      \
+    int next = (slot + 1) & (table->size - 1);                                 \
+    if (table->ctrl[next] == HT_TYPED_EMPTY) {                                 \
+      table->ctrl[slot] = HT_TYPED_EMPTY;                                      \
+    } else {                                                                   \
+      table->ctrl[slot] = HT_TYPED_DELETED;                                    \
+      ++table->deleted;                                                        \
+    }                                                                          \
+    --table->count;                                                            \
+  }                                                                            \
+                                                                               \
+  void ht_##NAME##_delete_all(ht_##NAME##_t *table) {                          \
+    free(table->ctrl);                                                         \
+    free(table->items);                                                        \
+    ht_##NAME##_init(table);                                                   \
+  }
+
+HTDEC(int, float, int, ht_hash_integer, HT_EQUALS)
+HTDEC(uint64_t, float, u64, ht_hash_integer, HT_EQUALS)
+HTDEC(const char *, float, str, ht_hash_string, ht_equals_string)
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Hromadné zpracování hodnot tabulky s rozptýlenými položkami
+ *
+ * Součet, minimum a maximum se počítají jedním průchodem. Souvislá pole
+ * hodnot (sloupce hodnot při překladu s HT_COLUMNAR) se zpracovávají
+ * instrukcemi AVX2, pokud je procesor podporuje. Hodnoty NaN se přeskakují,
+ * označují nepoužitá místa ve sloupcích.
+ */
+
+#include "hashtable_values.h"
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HT_AVX2
+#endif
+
+/// @brief Initializes aggregate of no values
+/// @param aggregate aggregate to initialize
+void ht_aggregate_init(ht_aggregate_t *aggregate) {
+    aggregate->sum = 0;
+    aggregate->min = INFINITY;
+    aggregate->max = -INFINITY;
+    aggregate->count = 0;
+}
+
+/// @brief Adds one value to the aggregate, usable with ht_for_each_value
+/// @param value value to add, skipped when it's NaN
+/// @param data ht_aggregate_t to add to
+void ht_aggregate_value(float value, void *data) {
+    ht_aggregate_t *aggregate = data;
+    if (isnan(value))
+        return;
+    aggregate->sum += value;
+    aggregate->min = value < aggregate->min ? value : aggregate->min;
+    aggregate->max = value > aggregate->max ? value : aggregate->max;
+    ++aggregate->count;
+}
+
+#ifdef HT_AVX2
+
+/// @brief Adds values to the aggregate, 8 at once
+/// @param aggregate aggregate to add to
+/// @param values values to add, NaN values are skipped
+/// @param count number of the values
+__attribute__((target("avx2"))) static void
+ht_aggregate_avx2(ht_aggregate_t *aggregate, const float *values,
+                  size_t count) {
+    // Sums are in doubles, floats would lose precision over many values
+    __m256d low = _mm256_setzero_pd();
+    __m256d high = _mm256_setzero_pd();
+    __m256 min = _mm256_set1_ps(aggregate->min);
+    __m256 max = _mm256_set1_ps(aggregate->max);
+    int found = 0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 value = _mm256_loadu_ps(values + i);
+        // NaN isn't ordered with itself, so it's masked out of the sum
+        __m256 ordered = _mm256_cmp_ps(value, value, _CMP_ORD_Q);
+        __m256 masked = _mm256_and_ps(value, ordered);
+        __m128 first = _mm256_castps256_ps128(masked);
+        __m128 second = _mm256_extractf128_ps(masked, 1);
+        low = _mm256_add_pd(low, _mm256_cvtps_pd(first));
+        high = _mm256_add_pd(high, _mm256_cvtps_pd(second));
+        // Min and max return the second operand when the first one is NaN
+        min = _mm256_min_ps(value, min);
+        max = _mm256_max_ps(value, max);
+        found += __builtin_popcount(_mm256_movemask_ps(ordered));
+    }
+
+    double sums[4];
+    float mins[8];
+    float maxs[8];
+    _mm256_storeu_pd(sums, _mm256_add_pd(low, high));
+    _mm256_storeu_ps(mins, min);
+    _mm256_storeu_ps(maxs, max);
+    aggregate->sum += sums[0] + sums[1] + sums[2] + sums[3];
+    for (int j = 0; j < 8; ++j) {
+        aggregate->min = mins[j] < aggregate->min ? mins[j] : aggregate->min;
+        aggregate->max = maxs[j] > aggregate->max ? maxs[j] : aggregate->max;
+    }
+    aggregate->count += found;
+
+    for (; i < count; ++i)
+        ht_aggregate_value(values[i], aggregate);
+}
+
+#endif // HT_AVX2
+
+/// @brief Adds contiguous values to the aggregate
+/// @param aggregate aggregate to add to
+/// @param values values to add, NaN values are skipped
+/// @param count number of the values
+void ht_aggregate_values(ht_aggregate_t *aggregate, const float *values,
+                         size_t count) {
+#ifdef HT_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        ht_aggregate_avx2(aggregate, values, count);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+        ht_aggregate_value(values[i], aggregate);
+}
+
+/// @brief Sums all values of the table
+/// @param table table to sum
+/// @return sum of the values, NaN values are skipped
+double ht_sum(ht_table_t *table) {
+    ht_aggregate_t aggregate;
+    ht_aggregate(table, &aggregate);
+    return aggregate.sum;
+}
+
+/// @brief Finds least and greatest value of the table
+/// @param table table to search
+/// @param min set to the least value
+/// @param max set to the greatest value
+/// @return false when the table has no values which aren't NaN, else true
+bool ht_minmax(ht_table_t *table, float *min, float *max) {
+    ht_aggregate_t aggregate;
+    ht_aggregate(table, &aggregate);
+    *min = aggregate.min;
+    *max = aggregate.max;
+    return aggregate.count > 0;
+}
@@ -0,0 +1,15 @@
+/*
+ * Hlavičkový soubor pro agregace hodnot tabulky.
+ */
+
+#ifndef IAL_HASHTABLE_VALUES_H
+#define IAL_HASHTABLE_VALUES_H
+
+#include "hashtable.h"
+
+void ht_aggregate_init(ht_aggregate_t *aggregate);
+void ht_aggregate_value(float value, void *aggregate);
+void ht_aggregate_values(ht_aggregate_t *aggregate, const float *values,
+                         size_t count);
+
+#endif
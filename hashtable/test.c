@@ -1,12 +1,17 @@
 #include "hashtable.h"
+#include "hashtable_frozen.h"
+#include "hashtable_rcu.h"
+#include "hashtable_shared.h"
+#include "hashtable_typed.h"
 #include "test_util.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define INSERT_TEST_DATA(TABLE)                                                \
   ht_insert_many(TABLE, TEST_DATA, sizeof(TEST_DATA) / sizeof(TEST_DATA[0]));
 
-const ht_item_t TEST_DATA[15] = {
+const ht_test_item_t TEST_DATA[15] = {
     {"Bitcoin", 53247.71}, {"Ethereum", 3208.67}, {"Binance Coin", 409.15},
     {"Cardano", 1.82},     {"Tether", 0.86},      {"XRP", 0.93},
     {"Solana", 134.50},    {"Polkadot", 34.99},   {"Dogecoin", 0.22},
@@ -39,7 +44,7 @@ TEST(test_search_exist, "Search for an existing item")
 ht_init(test_table);
 ht_insert(test_table, "Ethereum", 3208.67);
 ht_item_t *found = ht_search(test_table, "Ethereum");
-printf("Ethereum: %f\n", found->value);
+printf("Ethereum: %f\n", HT_VALUE(found));
 ENDTEST
 
 TEST(test_insert_many, "Insert many new items")
@@ -51,7 +56,7 @@ TEST(test_search_collision, "Search for an item with colliding hash")
 ht_init(test_table);
 INSERT_TEST_DATA(test_table)
 ht_item_t *found = ht_search(test_table, "Terra");
-printf("Terra: %f\n", found->value);
+printf("Terra: %f\n", HT_VALUE(found));
 ENDTEST
 
 TEST(test_insert_update, "Update an item")
@@ -67,6 +72,18 @@ float *found = ht_get(test_table, "Ethereum");
 printf("Ethereum: %f\n", *found);
 ENDTEST
 
+TEST(test_get_many, "Get values of many items at once")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+char *keys[] = {"Ethereum", "Monero", "Terra", "Bitcoin", "Stellar"};
+float *values[5];
+ht_get_many(test_table, keys, 5, values);
+for (int i = 0; i < 5; i++) {
+  printf("%s: ", keys[i]);
+  ht_print_item_value(values[i]);
+}
+ENDTEST
+
 TEST(test_delete, "Delete an item")
 printf("Deleting item: Terra\n");
 ht_init(test_table);
@@ -80,6 +97,623 @@ INSERT_TEST_DATA(test_table)
 ht_delete_all(test_table);
 ENDTEST
 
+TEST(test_resize, "Grow the table while inserting and deleting many items")
+ht_init(test_table);
+static char keys[40][16];
+for (int i = 0; i < 40; i++) {
+  snprintf(keys[i], sizeof(keys[i]), "Coin %i", i);
+  ht_insert(test_table, keys[i], i);
+}
+for (int i = 0; i < 40; i += 2) {
+  ht_delete(test_table, keys[i]);
+}
+int found = 0;
+for (int i = 0; i < 40; i++) {
+  found += ht_get(test_table, keys[i]) != NULL;
+}
+printf("Found: %i, items: %i, size: %i\n", found, test_table->count,
+       test_table->size);
+ENDTEST
+
+TEST(test_stats, "Get statistics of the table")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_search(test_table, "Terra");
+ht_search(test_table, "Monero");
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Items: %i, size: %i, load: %.2f, longest: %i\n", stats.count,
+       stats.size, stats.load, stats.max_length);
+printf("Old size: %i, old load: %.2f\n", stats.old_size, stats.old_load);
+printf("Lengths:");
+for (int i = 0; i < HT_HISTOGRAM; i++) {
+  printf(" %i", stats.histogram[i]);
+}
+printf("\nSearches: %lu, probes: %lu, hits: %lu, misses: %lu\n",
+       (unsigned long)stats.counters.searches,
+       (unsigned long)stats.counters.probes,
+       (unsigned long)stats.counters.hits,
+       (unsigned long)stats.counters.misses);
+ENDTEST
+
+TEST(test_owned_keys, "Insert keys which are changed afterwards")
+ht_init(test_table);
+char key[64] = "Ethereum";
+ht_insert(test_table, key, 3208.67);
+strcpy(key, "Ethereum Classic Proof of Work Chain Token");
+ht_insert(test_table, key, 19.46);
+strcpy(key, "Tether");
+ht_print_item(ht_search(test_table, "Ethereum"));
+ht_print_item(
+    ht_search(test_table, "Ethereum Classic Proof of Work Chain Token"));
+ht_print_item(ht_search(test_table, key));
+ht_delete(test_table, "Ethereum");
+ENDTEST
+
+TEST(test_snapshot, "Save the table and open it mapped")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_insert(test_table, "Ethereum Classic Proof of Work Chain Token", 19.46);
+bool saved = ht_save(test_table, "test_snapshot.ht");
+ht_delete_all(test_table);
+bool opened = ht_open_mapped(test_table, "test_snapshot.ht");
+printf("Saved: %s, opened: %s\n", saved ? "true" : "false",
+       opened ? "true" : "false");
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+ht_print_item_value(
+    ht_get(test_table, "Ethereum Classic Proof of Work Chain Token"));
+ht_print_item_value(ht_get(test_table, "Monero"));
+*ht_get(test_table, "Tether") = 1;
+ht_insert(test_table, "Monero", 241.03);
+ht_insert(test_table, "Solana", 140.10);
+ht_delete(test_table, "Bitcoin");
+ht_print_item(ht_search(test_table, "Terra"));
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Items: %i\n", stats.count);
+// Mapped table can replace the file it's mapped from
+saved = ht_save(test_table, "test_snapshot.ht");
+ht_delete_all(test_table);
+opened = ht_open_mapped(test_table, "test_snapshot.ht");
+printf("Saved: %s, opened: %s\n", saved ? "true" : "false",
+       opened ? "true" : "false");
+ht_print_item_value(ht_get(test_table, "Tether"));
+ht_print_item_value(ht_get(test_table, "Solana"));
+ht_print_item_value(ht_get(test_table, "Terra"));
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+ht_stats(test_table, &stats);
+printf("Items: %i\n", stats.count);
+remove("test_snapshot.ht");
+ENDTEST
+
+TEST(test_snapshot_alloc, "Keep mapped items when moving them fails")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_save(test_table, "test_alloc.ht");
+ht_delete_all(test_table);
+ht_open_mapped(test_table, "test_alloc.ht");
+test_alloc_fail = true;
+ht_item_t *failed = ht_search(test_table, "Bitcoin");
+ht_insert(test_table, "Tether", 1);
+test_alloc_fail = false;
+ht_print_item(failed);
+ht_print_item(ht_search(test_table, "Bitcoin"));
+ht_print_item_value(ht_get(test_table, "Tether"));
+ht_delete_all(test_table);
+ht_init(test_table);
+remove("test_alloc.ht");
+ENDTEST
+
+TEST(test_cache, "Evict items which weren't used recently")
+ht_init(test_table);
+ht_set_budget(test_table, 4, 0);
+ht_insert_many(test_table, TEST_DATA, 4);
+ht_get(test_table, "Bitcoin");
+ht_insert(test_table, "Tether", 0.86);
+ht_insert(test_table, "XRP", 0.93);
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+ht_print_item_value(ht_get(test_table, "XRP"));
+INSERT_TEST_DATA(test_table)
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+// Budget of bytes halves the table
+ht_set_budget(test_table, 0, stats.cache.bytes / 2);
+ht_stats(test_table, &stats);
+printf("Items: %i, hits: %lu, misses: %lu, evictions: %lu\n", stats.count,
+       (unsigned long)stats.cache.hits, (unsigned long)stats.cache.misses,
+       (unsigned long)stats.cache.evictions);
+ENDTEST
+
+TEST(test_accumulate, "Count keys by single search for each of them")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+bool inserted;
+float *value = ht_find_or_insert(test_table, "Bitcoin", &inserted);
+printf("Bitcoin: %.2f, inserted: %s\n", *value, inserted ? "true" : "false");
+value = ht_find_or_insert(test_table, "Monero", &inserted);
+printf("Monero: %.2f, inserted: %s\n", *value,
+       inserted ? "true" : "false");
+*value = 10;
+const char *words[] = {"Avalanche", "Monero", "Bitcoin", "Monero", "Monero"};
+for (int i = 0; i < 5; i++)
+  ht_accumulate(test_table, (char *)words[i], 1);
+printf("Last: %.2f\n", ht_accumulate(test_table, "Monero", 0.5));
+ENDTEST
+
+TEST(test_filter, "Reject missing keys by the filter")
+ht_init(test_table);
+ht_set_filter(test_table, 0.01);
+INSERT_TEST_DATA(test_table)
+// Table outgrows the filter and then deletes most of its keys, so the
+// filter is rebuilt in both cases
+char key[24];
+for (int i = 0; i < 600; i++) {
+  snprintf(key, sizeof(key), "Coin %i", i);
+  ht_insert(test_table, key, i);
+}
+int lost = 0;
+for (int i = 0; i < 600; i++) {
+  snprintf(key, sizeof(key), "Coin %i", i);
+  lost += ht_get(test_table, key) == NULL;
+  ht_delete(test_table, key);
+}
+for (int i = 0; i < 15; i++)
+  lost += ht_search(test_table, TEST_DATA[i].key) == NULL;
+int found = 0;
+for (int i = 0; i < 1000; i++) {
+  snprintf(key, sizeof(key), "Missing %i", i);
+  found += ht_get(test_table, key) != NULL;
+}
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Lost: %i, found missing: %i, target: %.2f, estimate below 1%%: %s, "
+       "most rejected: %s\n",
+       lost, found, stats.filter.target,
+       stats.filter.estimate < 0.01 ? "true" : "false",
+       stats.filter.rejects > 900 ? "true" : "false");
+ENDTEST
+
+TEST(test_typed, "Use tables specialized for int, uint64 and string keys")
+ht_init(test_table);
+ht_int_t ints;
+ht_u64_t ids;
+ht_str_t names;
+ht_int_init(&ints);
+ht_u64_init(&ids);
+ht_str_init(&names);
+// Tables grow several times and reuse slots of deleted items
+for (int i = -500; i < 500; i++)
+  ht_int_insert(&ints, i, i / 2.0);
+for (uint64_t i = 0; i < 1000; i++)
+  ht_u64_insert(&ids, i << 40, i);
+for (int i = 0; i < 15; i++)
+  ht_str_insert(&names, TEST_DATA[i].key, TEST_DATA[i].value);
+for (int i = -500; i < 500; i += 2)
+  ht_int_delete(&ints, i);
+for (int i = 0; i < 100; i++)
+  ht_int_insert(&ints, 1000 + i, i);
+ht_int_insert(&ints, 7, 70);
+ht_str_delete(&names, "Bitcoin");
+int lost = 0;
+for (int i = -499; i < 500; i += 2)
+  lost += ht_int_search(&ints, i) == NULL;
+for (uint64_t i = 0; i < 1000; i++) {
+  float *value = ht_u64_get(&ids, i << 40);
+  lost += value == NULL || *value != i;
+}
+printf("Ints: %i, ids: %i, names: %i, lost: %i\n", ints.count, ids.count,
+       names.count, lost);
+ht_print_item_value(ht_int_get(&ints, 7));
+ht_print_item_value(ht_int_get(&ints, 8));
+ht_print_item_value(ht_str_get(&names, "Ethereum"));
+ht_print_item_value(ht_str_get(&names, "Bitcoin"));
+ht_int_delete_all(&ints);
+ht_u64_delete_all(&ids);
+ht_str_delete_all(&names);
+ENDTEST
+
+float test_sum(float dst, float src) { return dst + src; }
+
+TEST(test_merge, "Merge word counts of two tables")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_table_t other;
+ht_init(&other);
+ht_insert(&other, "Bitcoin", 1);
+ht_insert(&other, "Monero", 241.03);
+ht_insert(&other, "Stellar", 0.29);
+ht_merge(test_table, &other, test_sum);
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+// Values of the other table replace the values without combine function
+ht_insert(&other, "Stellar", 1);
+ht_merge(test_table, &other, NULL);
+ht_delete_all(&other);
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+ht_print_item_value(ht_get(test_table, "Monero"));
+ht_print_item_value(ht_get(test_table, "Stellar"));
+ENDTEST
+
+TEST(test_slices, "Use slices of a buffer as keys")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+// Slices of all lengths hash like the same zero terminated keys
+const char *text = "Bitcoin Ethereum Monero Dogecoin Stellar Cardano";
+char copy[64];
+int mismatched = 0;
+for (size_t length = 0; length < strlen(text); length++) {
+  memcpy(copy, text, length);
+  copy[length] = 0;
+  mismatched += ht_hash_n(text, length) != ht_hash(copy, NULL);
+}
+printf("Mismatched hashes: %i\n", mismatched);
+ht_print_item_value(ht_get_n(test_table, text, 7));
+ht_print_item_value(ht_get_n(test_table, text + 8, 8));
+ht_print_item_value(ht_get_n(test_table, text, 3));
+ht_insert_n(test_table, text + 17, 6, 241.03);
+ht_delete_n(test_table, text + 8, 8);
+ht_print_item_value(ht_get(test_table, "Monero"));
+ht_print_item_value(ht_get(test_table, "Ethereum"));
+ht_print_item_value(ht_get(test_table, "Monero Dogecoin"));
+ht_item_t *item = ht_search_n(test_table, text + 17, 6);
+printf("Key: %s\n", item ? ht_item_key(item) : "NULL");
+// Lengths which don't fit the items are rejected before the key is read
+size_t huge = HT_MAX_KEY;
+ht_insert_n(test_table, text, huge, 1);
+ht_insert_hashed(test_table, text, huge + 7, ht_hash_n(text, 7), 1);
+ht_print_item_value(ht_get_n(test_table, text, huge));
+ht_print_item(ht_search_hashed(test_table, text, huge + 7, ht_hash_n(text, 7)));
+ht_print_item_value(ht_find_or_insert_hashed(test_table, text, huge + 7,
+                                             ht_hash_n(text, 7), NULL));
+ht_delete_n(test_table, text, huge);
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+ENDTEST
+
+TEST(test_freeze, "Search in frozen table with perfect hash")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_delete(test_table, "Tether");
+ht_frozen_t frozen;
+bool built = ht_freeze(test_table, &frozen);
+int lost = 0;
+for (int i = 0; i < 15; i++) {
+  float *value = ht_frozen_get(&frozen, TEST_DATA[i].key);
+  lost += strcmp(TEST_DATA[i].key, "Tether") != 0 &&
+          (value == NULL || *value != TEST_DATA[i].value);
+}
+*ht_frozen_get(&frozen, "Bitcoin") = 1;
+printf("Built: %s, count: %u, lost: %i\n", built ? "true" : "false",
+       frozen.count, lost);
+ht_print_item_value(ht_frozen_get(&frozen, "Bitcoin"));
+ht_print_item_value(ht_frozen_get(&frozen, "Tether"));
+ht_print_item_value(ht_frozen_get(&frozen, "Monero"));
+ht_frozen_free(&frozen);
+ht_print_item_value(ht_frozen_get(&frozen, "Bitcoin"));
+ENDTEST
+
+void test_freeze_missing() {
+  printf("[test_freeze_missing] Search for missing keys in frozen table\n");
+  static char keys[1000][24];
+  ht_table_t *table;
+  init_test_table(&table);
+  ht_init(table);
+  for (int i = 0; i < 1000; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "Coin %i", i);
+    ht_insert(table, keys[i], i);
+  }
+  ht_frozen_t frozen;
+  bool built = ht_freeze(table, &frozen);
+  // Missing keys land on all positions, including the spare ones no key took
+  int found = 0, lost = 0;
+  for (int i = 0; i < 100000; i++) {
+    char key[24];
+    snprintf(key, sizeof(key), "Token %i", i);
+    found += ht_frozen_get(&frozen, key) != NULL;
+  }
+  for (int i = 0; i < 1000; i++) {
+    float *value = ht_frozen_get(&frozen, keys[i]);
+    lost += value == NULL || *value != i;
+  }
+  printf("Built: %s, count: %u, found: %i, lost: %i\n",
+         built ? "true" : "false", frozen.count, found, lost);
+  ht_frozen_free(&frozen);
+  ht_delete_all(table);
+  free(table);
+  printf("\n");
+}
+
+void test_freeze_small() {
+  printf("[test_freeze_small] Freeze tables with up to 3 items\n");
+  for (int count = 0; count <= 3; count++) {
+    ht_table_t *table;
+    init_test_table(&table);
+    ht_init(table);
+    ht_insert_many(table, TEST_DATA, count);
+    ht_frozen_t frozen;
+    bool built = ht_freeze(table, &frozen);
+    int found = 0;
+    for (int i = 0; i < 15; i++) {
+      float *value = ht_frozen_get(&frozen, TEST_DATA[i].key);
+      found += value != NULL && *value == TEST_DATA[i].value;
+    }
+    printf("Items: %i, built: %s, buckets: %u, found: %i\n", count,
+           built ? "true" : "false", frozen.buckets, found);
+    ht_frozen_free(&frozen);
+    ht_delete_all(table);
+    free(table);
+  }
+  printf("\n");
+}
+
+void test_count_value(float value, void *count) {
+  (void)value;
+  ++*(int *)count;
+}
+
+TEST(test_aggregate, "Aggregate all values of the table")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_delete(test_table, "Bitcoin");
+ht_delete(test_table, "Dogecoin");
+float min, max;
+bool found = ht_minmax(test_table, &min, &max);
+int count = 0;
+ht_for_each_value(test_table, test_count_value, &count);
+printf("Sum: %.2f, min: %.2f, max: %.2f, found: %s, count: %i\n",
+       ht_sum(test_table), min, max, found ? "true" : "false", count);
+ENDTEST
+
+TEST(test_iter, "Iterate while the table grows and items are deleted")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+static char keys[300][24];
+int returned[15] = {0};
+int others = 0;
+int count = 0;
+ht_iter_t iter;
+ht_iter_begin(test_table, &iter);
+const char *key;
+float *value;
+while (ht_iter_next(&iter, &key, &value)) {
+  bool original = false;
+  for (int i = 0; i < 15; i++) {
+    if (strcmp(key, TEST_DATA[i].key) == 0) {
+      ++returned[i];
+      original = true;
+    }
+  }
+  others += !original;
+  // Every step grows the table and deletes one of the original items
+  for (int i = 0; i < 20 && count < 300; i++, count++) {
+    snprintf(keys[count], sizeof(keys[count]), "Coin %i", count);
+    ht_insert(test_table, keys[count], count);
+  }
+  if (count == 60) {
+    ht_delete(test_table, "Terra");
+  }
+}
+int missing = 0;
+int twice = 0;
+for (int i = 0; i < 15; i++) {
+  missing += returned[i] == 0 && strcmp(TEST_DATA[i].key, "Terra") != 0;
+  twice += returned[i] > 1;
+}
+printf("Missing: %i, returned twice: %i, inserted returned: %s\n", missing,
+       twice, others > 0 ? "some" : "none");
+const char *exported[400];
+float values[400];
+int exported_count = ht_export(test_table, exported, values, 400);
+float sum = 0;
+for (int i = 0; i < exported_count; i++) {
+  sum += values[i];
+}
+printf("Exported: %i, sum: %.2f\n", exported_count, sum);
+ht_delete_all(test_table);
+ht_init(test_table);
+ENDTEST
+
+TEST(test_iter_snapshot, "Iterate while items move from mapped snapshot")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_save(test_table, "test_iter.ht");
+ht_delete_all(test_table);
+ht_open_mapped(test_table, "test_iter.ht");
+int returned[15] = {0};
+ht_iter_t iter;
+ht_iter_begin(test_table, &iter);
+const char *key;
+float *value;
+while (ht_iter_next(&iter, &key, &value)) {
+  for (int i = 0; i < 15; i++) {
+    if (strcmp(key, TEST_DATA[i].key) == 0) {
+      ++returned[i];
+    }
+  }
+  // Found item moves to the table, it may be returned again from there
+  ht_search(test_table, (char *)key);
+}
+int missing = 0;
+int twice = 0;
+int more = 0;
+for (int i = 0; i < 15; i++) {
+  missing += returned[i] == 0;
+  twice += returned[i] == 2;
+  more += returned[i] > 2;
+}
+printf("Missing: %i, returned twice: %s, more times: %i\n", missing,
+       twice > 0 ? "some" : "none", more);
+ht_delete_all(test_table);
+ht_init(test_table);
+remove("test_iter.ht");
+ENDTEST
+
+void test_build_parallel() {
+  printf("[test_build_parallel] Build shared table on many threads\n");
+  // Last 15 items repeat the keys, so their values win
+  static char keys[1015][24];
+  static ht_pair_t items[1015];
+  for (int i = 0; i < 1015; i++) {
+    if (i < 1000) {
+      snprintf(keys[i], sizeof(keys[i]), "Coin %i", i);
+      items[i].key = keys[i];
+    } else {
+      items[i].key = TEST_DATA[i - 1000].key;
+    }
+    items[i].value = i;
+  }
+  for (int i = 0; i < 15; i++) {
+    items[i * 10].key = TEST_DATA[i].key;
+  }
+  ht_shared_t table;
+  ht_build_parallel(&table, items, 1015, 3);
+  int count = 0;
+  for (int i = 0; i <= table.mask; i++) {
+    count += table.shards[i].table.count;
+  }
+  float value;
+  int lost = 0;
+  for (int i = 0; i < 1000; i++) {
+    lost += i % 10 != 0 && !ht_shared_get(&table, keys[i], &value);
+  }
+  ht_shared_get(&table, "Bitcoin", &value);
+  printf("Shards: %i, items: %i, lost: %i, Bitcoin: %.2f\n", table.mask + 1,
+         count, lost, value);
+  ht_shared_delete_all(&table);
+  printf("\n");
+}
+
+void *test_shared_worker(void *table) {
+  for (int i = 0; i < 1500; i++) {
+    ht_shared_add(table, TEST_DATA[i % 15].key, 1);
+  }
+  return NULL;
+}
+
+void test_shared_add() {
+  printf("[test_shared_add] Add to values from many threads at once\n");
+  ht_shared_t table;
+  ht_shared_init(&table, 4);
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, test_shared_worker, &table);
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  for (int i = 0; i < 15; i++) {
+    float value;
+    ht_shared_get(&table, TEST_DATA[i].key, &value);
+    printf("%s: %.2f\n", TEST_DATA[i].key, value);
+  }
+  // Long key has to be allocated, so the add fails
+  test_alloc_fail = true;
+  float failed =
+      ht_shared_add(&table, "Ethereum Classic Proof of Work Chain Token", 1);
+  test_alloc_fail = false;
+  printf("Failed add: %.2f\n", failed);
+  ht_shared_delete_all(&table);
+  printf("\n");
+}
+
+atomic_bool test_rcu_done;
+
+void *test_rcu_reader(void *table) {
+  ht_rcu_reader_t *reader = ht_rcu_register(table);
+  while (!atomic_load(&test_rcu_done)) {
+    for (int i = 0; i < 15; i++) {
+      float value;
+      if (ht_rcu_get(table, reader, TEST_DATA[i].key, &value) &&
+          value != TEST_DATA[i].value) {
+        printf("Wrong value of %s: %.2f\n", TEST_DATA[i].key, value);
+      }
+    }
+  }
+  ht_rcu_unregister(reader);
+  return NULL;
+}
+
+void test_rcu_concurrent() {
+  printf("[test_rcu_concurrent] Read while other thread writes\n");
+  ht_rcu_t table;
+  ht_rcu_init(&table);
+  atomic_store(&test_rcu_done, false);
+  pthread_t readers[2];
+  for (int i = 0; i < 2; i++) {
+    pthread_create(&readers[i], NULL, test_rcu_reader, &table);
+  }
+  // Table grows and shrinks many times while it's read
+  static char keys[200][16];
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < 15; i++) {
+      ht_rcu_insert(&table, TEST_DATA[i].key, TEST_DATA[i].value);
+    }
+    for (int i = 0; i < 200; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "Coin %i", i);
+      ht_rcu_insert(&table, keys[i], i);
+    }
+    for (int i = 0; i < 200; i++) {
+      ht_rcu_delete(&table, keys[i]);
+    }
+    for (int i = 0; i < 15; i += 2) {
+      ht_rcu_delete(&table, TEST_DATA[i].key);
+    }
+  }
+  atomic_store(&test_rcu_done, true);
+  for (int i = 0; i < 2; i++) {
+    pthread_join(readers[i], NULL);
+  }
+  printf("Items: %i\n", table.count);
+  ht_rcu_delete_all(&table);
+  printf("\n");
+}
+
+#ifndef HT_SWISS
+
+void test_cache_rehash() {
+  printf("[test_cache_rehash] Evict items while the table is rehashed\n");
+  static char keys[1000][24];
+  ht_table_t *table;
+  init_test_table(&table);
+  ht_init(table);
+  int count = 0;
+  while (count < 1000 && (count < 100 || !table->old_items)) {
+    snprintf(keys[count], sizeof(keys[count]), "Coin %i", count);
+    ht_insert(table, keys[count], count);
+    count++;
+  }
+  int old_size = table->old_size;
+  // Eviction doesn't move the rest of the old lists at once
+  ht_set_budget(table, count - 20, 0);
+  int found = 0;
+  for (int i = 0; i < count; i++) {
+    float *value = ht_get(table, keys[i]);
+    found += value != NULL && *value == i;
+  }
+  printf("Rehashing: %s, same old array: %s, items: %i, found: %i\n",
+         table->old_items ? "yes" : "no",
+         table->old_size == old_size ? "yes" : "no", table->count, found);
+  ht_delete_all(table);
+  free(table);
+  printf("\n");
+}
+
+TEST(test_slab_reuse, "Reuse memory of deleted items")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+size_t live, reserved;
+ht_slab_stats(test_table, &live, &reserved);
+printf("Live: %zu, reserved: %zu\n", live, reserved);
+ht_delete(test_table, "Bitcoin");
+ht_delete(test_table, "Terra");
+ht_slab_stats(test_table, &live, &reserved);
+printf("Live: %zu, reserved: %zu\n", live, reserved);
+ht_insert(test_table, "Monero", 241.03);
+ht_insert(test_table, "Stellar", 0.35);
+ht_slab_stats(test_table, &live, &reserved);
+printf("Live: %zu, reserved: %zu\n", live, reserved);
+ENDTEST
+
+#endif // HT_SWISS
+
 int main(int argc, char *argv[]) {
   init_uninitialized_item();
   init_test();
@@ -92,8 +726,33 @@ int main(int argc, char *argv[]) {
   test_search_collision();
   test_insert_update();
   test_get();
+  test_get_many();
   test_delete();
   test_delete_all();
+  test_resize();
+  test_stats();
+  test_owned_keys();
+  test_snapshot();
+  test_snapshot_alloc();
+  test_cache();
+  test_accumulate();
+  test_filter();
+  test_typed();
+  test_merge();
+  test_slices();
+  test_freeze();
+  test_freeze_missing();
+  test_freeze_small();
+  test_aggregate();
+  test_iter();
+  test_iter_snapshot();
+  test_shared_add();
+  test_build_parallel();
+  test_rcu_concurrent();
+#ifndef HT_SWISS
+  test_cache_rehash();
+  test_slab_reuse();
+#endif
 
   free(uninitialized_item);
 }
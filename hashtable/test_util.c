@@ -2,8 +2,26 @@
 #include "hashtable.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 ht_item_t *uninitialized_item;
+bool test_alloc_fail = false;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  return test_alloc_fail ? NULL : __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  return test_alloc_fail ? NULL : __real_calloc(count, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size) {
+  return test_alloc_fail ? NULL : __real_aligned_alloc(alignment, size);
+}
 
 void ht_print_item_value(float *value) {
   if (value != NULL) {
@@ -15,34 +33,56 @@ void ht_print_item_value(float *value) {
 
 void ht_print_item(ht_item_t *item) {
   if (item != NULL) {
-    printf("(%s,%.2f)\n", item->key, item->value);
+    printf("(%s,%.2f)\n", ht_item_key(item), HT_VALUE(item));
   } else {
     printf("NULL\n");
   }
 }
 
+void ht_print_list(ht_item_t *item, int *max_count, int *sum_count) {
+  int count = 0;
+  while (item != NULL) {
+    printf("(%s,%.2f)", ht_item_key(item), HT_VALUE(item));
+    if (item != uninitialized_item) {
+      count++;
+    }
+#ifdef HT_SWISS
+    item = NULL;
+#else
+    item = item->next;
+#endif
+  }
+  printf("\n");
+  if (count > *max_count) {
+    *max_count = count;
+  }
+  *sum_count += count;
+}
+
 void ht_print_table(ht_table_t *table) {
   int max_count = 0;
   int sum_count = 0;
 
   printf("------------HASH TABLE--------------\n");
-  for (int i = 0; i < HT_SIZE; i++) {
+#ifdef HT_SWISS
+  for (int i = 0; i < table->size; i++) {
     printf("%i: ", i);
-    int count = 0;
-    ht_item_t *item = (*table)[i];
-    while (item != NULL) {
-      printf("(%s,%.2f)", item->key, item->value);
-      if (item != uninitialized_item) {
-        count++;
-      }
-      item = item->next;
-    }
-    printf("\n");
-    if (count > max_count) {
-      max_count = count;
+    bool full = table->ctrl == NULL || table->ctrl[i] >= 0;
+    ht_print_list(full ? &table->items[i] : NULL, &max_count, &sum_count);
+  }
+#else
+  for (int i = 0; i < table->size; i++) {
+    printf("%i: ", i);
+    ht_print_list(table->items[i], &max_count, &sum_count);
+  }
+  if (table->old_items != NULL) {
+    printf("-----------REHASHED FROM------------\n");
+    for (int i = 0; i < table->old_size; i++) {
+      printf("%i: ", i);
+      ht_print_list(table->old_items[i], &max_count, &sum_count);
     }
-    sum_count += count;
   }
+#endif
 
   printf("------------------------------------\n");
   printf("Total items in hash table: %i\n", sum_count);
@@ -51,20 +91,50 @@ void ht_print_table(ht_table_t *table) {
 }
 
 void init_uninitialized_item() {
+#ifdef HT_SWISS
   uninitialized_item = (ht_item_t *)malloc(sizeof(ht_item_t));
-  uninitialized_item->key = "*UNINITIALIZED*";
-  uninitialized_item->value = -1;
+#else
+  uninitialized_item = (ht_item_t *)malloc(HT_ITEM_SIZE);
+#endif
+  strcpy(uninitialized_item->key, "*UNINITIALIZED*");
+  uninitialized_item->length = strlen("*UNINITIALIZED*");
+#if defined(HT_COLUMNAR) && !defined(HT_SWISS)
+  static float uninitialized_value;
+  uninitialized_item->value = &uninitialized_value;
+#endif
+  HT_VALUE(uninitialized_item) = -1;
+#ifndef HT_SWISS
   uninitialized_item->next = NULL;
+#endif
+  uninitialized_item->hash = 0;
 }
 
 void init_test_table(ht_table_t **table) {
   (*table) = (ht_table_t *)malloc(sizeof(ht_table_t));
-  for (int i = 0; i < MAX_HT_SIZE; i++) {
-    (**table)[i] = uninitialized_item;
-  };
+#ifdef HT_SWISS
+  (*table)->ctrl = NULL;
+  (*table)->items = uninitialized_item;
+  (*table)->deleted = 0;
+  (*table)->resizes = 0;
+#else
+  (*table)->items = &uninitialized_item;
+  (*table)->old_items = NULL;
+  (*table)->old_size = 0;
+  (*table)->rehash_index = 0;
+  (*table)->slabs = NULL;
+  (*table)->slab_used = 0;
+  (*table)->free_items = NULL;
+  (*table)->long_keys = 0;
+#endif
+  (*table)->snapshot = NULL;
+  memset(&(*table)->cache, 0, sizeof((*table)->cache));
+  (*table)->filter = NULL;
+  (*table)->size = 1;
+  (*table)->count = -1;
 }
 
-void ht_insert_many(ht_table_t *table, const ht_item_t items[], int count) {
+void ht_insert_many(ht_table_t *table, const ht_test_item_t items[],
+                    int count) {
   for (int i = 0; i < count; i++) {
     ht_insert(table, items[i].key, items[i].value);
   }
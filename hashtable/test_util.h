@@ -17,12 +17,22 @@
   printf("\n");                                                                \
   }
 
+// Key and value of an item inserted by tests
+typedef struct ht_test_item {
+  char *key;
+  float value;
+} ht_test_item_t;
+
 extern ht_item_t *uninitialized_item;
+// Allocations of the table fail while set
+extern bool test_alloc_fail;
 
 void ht_print_item_value(float *value);
 void ht_print_item(ht_item_t *item);
+void ht_print_list(ht_item_t *item, int *max_count, int *sum_count);
 void ht_print_table(ht_table_t *table);
-void ht_insert_many(ht_table_t *table, const ht_item_t items[], int count);
+void ht_insert_many(ht_table_t *table, const ht_test_item_t items[],
+                    int count);
 
 void init_uninitialized_item();
 void init_test_table(ht_table_t **table);